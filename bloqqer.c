@@ -13,6 +13,11 @@
 #include <unistd.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#if defined(SIGWORDS) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
 #include "bloqqer.h"
 
 #ifdef SOLVER
@@ -432,6 +437,10 @@ static int loglevel;
 
 typedef unsigned long long Sig;
 
+#ifndef SIGWORDS
+#define SIGWORDS 1		/* words of clause signatures ('-w' gives 4) */
+#endif
+
 typedef struct Occ {		/* occurrence list anchor */
   int count;
   struct Node * first, * last;
@@ -451,6 +460,14 @@ typedef enum Tag {
   UNIT = 10,
 } Tag;
 
+typedef enum GateType {		/* gate definitions used in elimination */
+  NO_GATE = 0,
+  EQUIV_GATE = 1,
+  AND_GATE = 2,
+  XOR_GATE = 3,
+  ITE_GATE = 4,
+} GateType;
+
 typedef struct Var {
   struct Scope * scope;
   Tag tag;
@@ -460,7 +477,11 @@ typedef struct Var {
   int mapped;			/* index mapped to */
   int fixed;			/* assignment */
   int score, pos;		/* for elimination priority queue */
+  int dirty;			/* score update deferred in bulk insertion */
   int expcopy;			/* copy in expansion */
+  int touched;			/* last expansion epoch of occurrence change */
+  int expstamp, expcost, expbound;	/* cached expansion cost */
+  int * cone, ncone;		/* variables traversed for cached cost */
   struct Var * prev, * next;	/* scope variable list links */
   Occ occs[2];			/* positive and negative occurrence lists */
 } Var;
@@ -495,7 +516,9 @@ typedef struct Clause {
   int size;
   int mark, cmark2;
   int count; 
-  Sig sig;			/* subsumption/strengthening signature */
+  int maxorder;			/* innermost scope order of literals */
+  int gate;			/* gate clause of eliminated variable */
+  Sig sig[SIGWORDS];		/* subsumption/strengthening signature */
   struct Clause * prev, * next;	/* chronlogical clause list links */
   struct Clause * head, * tail;	/* backward subsumption queue links */
   Watch watch;			/* forward subsumption watch */
@@ -520,12 +543,19 @@ typedef struct StrOpt {
 static int verbose, bce, ble, eq, ve, quantifyall, force, strict, keep, output;
 static int help, range, defaults, bound, hte, htesize, hteoccs, htesteps;
 static int embedded, ignore, cce, hbce, hble, exp, axcess, splitlim;
-static int fwmaxoccs, fwmax1size, fwmax2size;
+static int sigbits, sortlits, fwmaxoccs, fwmax1size, fwmax2size;
 static int bwmaxoccs, bwmax1size, bwmax2size;
 static int blkmax1occs, blkmax2occs;
 static int blkmax1size, blkmax2size;
 static int elimoccs, elimsize, excess;
+static int subsume, substeps, unhide, probe, probesteps, gates, depscheme;
+static int reorder;
+static int vivification, vivifysteps, asymmetric, atesteps, bva, bvasteps;
 static int timelimit;
+static int portfolio, objective, components, threads;
+static int sat, satconflicts;
+static int relaxsat, reducesat, relaxconflicts, relaxtime;
+static int expsolve, expmem, expblock, explook;
 static int implicit_scopes_inited;
 static int partial_assignment;
 static int assigned_scope = -1;
@@ -558,6 +588,7 @@ static void block_lit (int);
 static int trail_flushed (void);
 
 static void push_stack (int elem);
+static void push_aux (int elem);
 static int is_trivial_on_stack () ;
 static int is_trivial_clause (Clause *) ;
 static void flush_vars (); 
@@ -591,19 +622,40 @@ static Opt opts[] = {
 {'u',"exp-mini",1,0,1,"miniscoping during expansion",&univ_mini},
 {000,"timeout",0,0,IM,"set time limit",&timelimit},
 {000,"guess",0,0,IM,"guess random univ. expansions",&guessnumber},
+{000,"portfolio",0,0,8,"run that many configurations in parallel",&portfolio},
+{000,"objective",0,0,3,"portfolio objective (clauses,literals,result,time)",&objective},
+{000,"components",0,0,64,"preprocess connected components in that many processes",&components},
+{000,"threads",0,0,64,"worker threads for resolvent counting and expansion",&threads},
 {000,"split",512,3,IM,"split long clauses of at least this length",&splitlim},
 {000,"bce",1,0,1,"enable blocked clause elimination",&bce},
 {000,"ble",1,0,1,"enable blocked literal elimination",&ble},
 {000,"eq",1,0,1,"enable equivalent literal reasoning",&eq},
 {000,"ve",1,0,1,"enable variable elimination",&ve},
+{000,"gates",1,0,1,"enable gate detection in variable elimination",&gates},
+{000,"depscheme",1,0,2,"dependency scheme (0=prefix,1=standard,2=resolution-path)",&depscheme},
+{000,"reorder",0,0,1,"shift existentials outward by standard dependencies (any depscheme)",&reorder},
 {000,"exp",1,0,1,"enable variable expansion",&exp},
+{000,"expsolve",0,0,1,"expand until propositional ignoring '--axcess'",&expsolve},
+{000,"expblock",1,1,IM,"max universals of one scope expanded at once",&expblock},
+{000,"explook",0,0,IM,"rank this many expansion candidates by lookahead",&explook},
+{000,"sat",1,0,1,"solve propositional formulas with embedded SAT solver",&sat},
 {000,"hte",1,0,1,"enable hidden clause elimination",&hte},
 {000,"cce",1,0,1,"enable covered literal addition",&cce},
 {000,"hbce",1,0,1,"enable hidden blocked clause elimination",&hbce},
 {000,"hble",0,0,1,"enable asymmetrick blocked literal  elimination",&hble},
+{000,"unhide",1,0,IM,"unhiding rounds on binary implication graph",&unhide},
+{000,"probe",1,0,1,"enable failed literal probing",&probe},
+{000,"vivify",1,0,1,"enable clause vivification",&vivification},
+{000,"ate",1,0,1,"enable asymmetric tautology and qrat clause elimination",&asymmetric},
+{000,"bva",1,0,1,"enable bounded variable addition",&bva},
+{000,"subsume",1,0,1,"enable global subsumption rounds",&subsume},
 {'s',"strict",0,0,1,"enforce strict variable elimination",&strict},
 {000,"excess",20,-IM,IM,"excess limit in variable elimination",&excess},
 {000,"axcess",2000,-IM,IM,"excess limit in variable expansion",&axcess},
+#if SIGWORDS > 1
+{000,"sigbits",64,64,64*SIGWORDS,"bits of clause signatures",&sigbits},
+#endif
+{000,"sortlits",0,0,2,"sort clause literals by index (1) or order (2)",&sortlits},
 {000,"fwmaxoccs",32,0,IM,"forward max occurrences",&fwmaxoccs},
 {000,"fwmax1size",32,0,IM,"inner forward max clause size", &fwmax1size},
 {000,"fwmax2size",64,0,IM,"outer forward max clause size", &fwmax2size},
@@ -618,8 +670,19 @@ static Opt opts[] = {
 {000,"elimsize",32,0,IM,"max eliminated clauses size",&elimsize},
 {000,"bound",1024,-1,IM,"bound for all bw/fw/block/elim limits",&bound},
 {000,"htesteps",64,0,IM,"hte steps bound",&htesteps},
+{000,"substeps",10000000,0,IM,"global subsumption steps bound",&substeps},
+{000,"probesteps",1000000,0,IM,"failed literal probing steps bound",&probesteps},
+{000,"vivifysteps",100000,0,IM,"vivification steps bound",&vivifysteps},
+{000,"atesteps",100000,0,IM,"asymmetric tautology elimination steps bound",&atesteps},
+{000,"bvasteps",1000000,0,IM,"bounded variable addition steps bound",&bvasteps},
 {000,"hteoccs",32,0,IM,"hte max occurrences size",&hteoccs},
 {000,"htesize",1024,2,IM,"hte max clause size",&htesize},
+{000,"expmem",1024,0,IM,"memory limit in MB for '--expsolve'",&expmem},
+{000,"satconflicts",1000000,0,IM,"conflict limit of embedded SAT solver",&satconflicts},
+{000,"relaxsat",0,0,1,"refute by SAT on the existential relaxation",&relaxsat},
+{000,"reducesat",0,0,1,"satisfy by SAT with universal literals removed",&reducesat},
+{000,"relaxconflicts",10000,0,IM,"conflict limit of relaxation checks",&relaxconflicts},
+{000,"relaxtime",1,0,IM,"time limit in seconds of relaxation checks",&relaxtime},
 {000,0},
 };
 
@@ -638,7 +701,10 @@ static int nqueue;
 
 static int num_vars, orig_num_vars, fixed, elimidx, substituting = 0, substituting2 = 0;
 static int no_lookup = 0;
+static int gate_clauses;
 static int expanding = 0;
+static int bulk_adding = 0, deferring_scores = 0;
+static Clause * fwskip;
 static int universal_vars, existential_vars, implicit_vars;
 static int * schedule, size_schedule;
 static int * trail, * top_of_trail, * next_on_trail;
@@ -652,6 +718,8 @@ static Var * vars;
 static int nstack, szstack, * stack;
 static int num_lits, size_lits, * lits;
 static int naux, szaux, * aux;
+static int nbulk, szbulk, * bulk;
+static int ndirty, szdirty, * dirty;
 static int nline, szline;
 static char * line;
 
@@ -660,14 +728,27 @@ static int embedded_options, command_line_options;
 static int added_clauses, added_binary_clauses, enqueued_clauses, pushed_vars;
 static int subsumed_clauses, strengthened_clauses;
 static int forward_subsumed_clauses, forward_strengthened_clauses;
+static int bulk_batches, bulk_subsumed_clauses, bulk_strengthened_clauses;
+static int subsume_rounds, round_subsumed_clauses, round_strengthened_clauses;
+static int unhide_rounds, unhidden_tautologies, unhidden_literals;
+static int unhidden_units, unhidden_transitive;
+static int probe_rounds, probed_lits, failed_lits, lifted_lits;
+static int vivify_rounds, vivified_clauses, vivified_lits, vivified_redundant;
+static int ate_rounds, ate_clauses, qrate_clauses;
+static int bva_vars, bva_added, bva_removed;
 static int backward_subsumed_clauses, backward_strengthened_clauses;
 static int blocked_clauses, blocked_lits, orig_clauses, num_clauses, hidden_tautologies;
 static int units, unates, unets, zombies, eliminated, remaining, mapped,
 outermost_blocked;
 static int substituted, eqrounds, nonstrictves, hidden_blocked_clauses;
 static int hidden_blocked_literals;
+static int gate_eliminations, gate_types[5];
+static int dep_computations, dep_blocked, dep_eliminated, dep_uncopied;
+static int reorders, reordered_vars, reordered_clauses;
 static int added_binary_clauses_at_last_eqround;
-static int expanded, expansion_cost_mark;
+static int expanded, block_expanded, expansion_cost_mark;
+static int exp_epoch = 1, exp_valid_epoch, stretched;
+static int64_t exp_cache_lookups, exp_cache_hits;
 static struct { struct { int64_t lookups, hits; } sig1, sig2; } fw, bw;
 static long long hlas, clas;
 static Clause * cl_iterator;
@@ -676,7 +757,8 @@ static Node * lit_iterator;
 static double bceTime = 0, eqTime = 0, veTime = 0, cceTime = 0, hteTime = 0;
 static double hbceTime = 0, splitTime = 0, expTime = 0, subsTime = 0;
 static double univredTime = 0, strengthTime = 0, trivclauseTime = 0;
-static double parseTime = 0, pureTime = 0;
+static double parseTime = 0, pureTime = 0, unhideTime = 0, depTime = 0;
+static double probeTime = 0, vivifyTime = 0, ateTime = 0, bvaTime = 0;
 static double elimTime = 0, flushTime = 0;
 static void unmark2_lits (void);
 static void unmark_lits (void);
@@ -970,7 +1052,10 @@ static void forall_reduce_clause (void) {
   double start = seconds();
   int unsat = 0;
   order = 0;
-  for (i = 0; i < num_lits; i++) {
+  if (sortlits > 1) {
+    for (i = num_lits - 1; i >= 0; i--)	/* last existential is innermost */
+      if (existential (lits[i])) { order = lit2order (lits[i]); break; }
+  } else for (i = 0; i < num_lits; i++) {
     lit = lits[i];
     assert (!deref (lit));
     if (universal (lit)) continue;
@@ -1398,6 +1483,18 @@ static void update_score (int idx) {
   if (new_score > old_score && v->pos >= 0) down (idx);
 }
 
+static void defer_score (int idx) {
+  Var * v = lit2var (idx);
+  if (v->dirty) return;
+  if (szdirty == ndirty) {
+    int new_size = szdirty ? 2*szdirty : 1;
+    RSZ (dirty, szdirty, new_size);
+    szdirty = new_size;
+  }
+  dirty[ndirty++] = idx;
+  v->dirty = 1;
+}
+
 static void add_node (Clause * clause, Node * node, int lit) {
   Occ * occ;
   assert (clause->nodes <= node && node < clause->nodes + clause->size);
@@ -1410,8 +1507,10 @@ static void add_node (Clause * clause, Node * node, int lit) {
   else occ->first = node;
   occ->last = node;
   occ->count++;
+  lit2var (lit)->touched = exp_epoch;
   LOG ("number of occurrences of %d increased to %d", lit, occ->count);
-  update_score (abs (lit));
+  if (deferring_scores) defer_score (abs (lit));
+  else update_score (abs (lit));
 }
 
 static int enqueued (Clause * clause) {
@@ -1464,6 +1563,116 @@ static Sig lit2sig (int lit) {
   return 1ull << ((100623947llu * (Sig) abs (lit)) & 63llu);
 }
 
+/* Wide signatures set a second bit for each variable in the words after
+ * the first one, which stays the plain 64 bit signature.  Long clauses
+ * saturate 64 bits quickly, while the extra words keep filtering.  Since
+ * every clause carries 'SIGWORDS' words, they are only compiled in with
+ * './configure -w', which adds '--sigbits' (up to 256).  Otherwise
+ * 'sigbits' stays zero and only the first word is used.
+ */
+static void lit2wsig (int lit, Sig * wsig) {
+#if SIGWORDS > 1
+  unsigned h;
+#endif
+  wsig[0] |= lit2sig (lit);
+#if SIGWORDS > 1
+  if (sigbits <= 64) return;
+  h = (2654435761u * (unsigned) abs (lit)) >> 7;
+  h %= (unsigned) (sigbits - 64);
+  wsig[1 + (h >> 6)] |= 1ull << (h & 63);
+#endif
+}
+
+/* With '--sortlits' the literals of all clauses are kept sorted by this
+ * order, which ignores the sign of literals in its first two keys.
+ */
+static int cmp_sorted_vars (int a, int b) {
+  int res;
+  if (sortlits > 1 && (res = lit2order (a) - lit2order (b))) return res;
+  return abs (a) - abs (b);
+}
+
+static int cmp_sorted_lits (const void * p, const void * q) {
+  int a = *(const int *) p, b = *(const int *) q, res;
+  if ((res = cmp_sorted_vars (a, b))) return res;
+  return a - b;
+}
+
+static void sort_lits (int * st, int size) {
+  if (size > 1) qsort (st, size, sizeof *st, cmp_sorted_lits);
+}
+
+/* Merge based containment checks on sorted clauses.  They return INT_MAX
+ * if all literals of 'c' occur in 'd', the literal of 'd' if exactly one
+ * occurs negated and zero otherwise.
+ */
+static int merge_nodes (const Node * c, const Node * d) {
+  int a, b, cmp, res = INT_MAX;
+  while ((a = c->lit)) {
+    if (!(b = d->lit)) return 0;
+    cmp = cmp_sorted_vars (a, b);
+    if (cmp > 0) { d++; continue; }
+    if (cmp < 0) return 0;
+    if (a != b) {
+      if (res != INT_MAX) return 0;
+      res = b;
+    }
+    c++, d++;
+  }
+  return res;
+}
+
+static int merge_lits (const Node * c, const int * d, int n) {
+  int a, cmp, i = 0, res = INT_MAX;
+  while ((a = c->lit)) {
+    if (i == n) return 0;
+    cmp = cmp_sorted_vars (a, d[i]);
+    if (cmp > 0) { i++; continue; }
+    if (cmp < 0) return 0;
+    if (a != d[i]) {
+      if (res != INT_MAX) return 0;
+      res = d[i];
+    }
+    c++, i++;
+  }
+  return res;
+}
+
+/* Non zero if 'a' has a bit not in 'b', which means that the clause of
+ * 'a' can not be a subset of the clause of 'b', modulo negation.
+ */
+static int wsig_excluded (const Sig * a, const Sig * b) {
+  if (sigbits <= 64) return (a[0] & ~b[0]) != 0;
+#if SIGWORDS != 4
+  {
+    Sig res = 0;
+    int i;
+    for (i = 0; i < SIGWORDS; i++) res |= a[i] & ~b[i];
+    return res != 0;
+  }
+#elif defined(__AVX2__)
+  {
+    __m256i x = _mm256_loadu_si256 ((const __m256i *) a);
+    __m256i y = _mm256_loadu_si256 ((const __m256i *) b);
+    return !_mm256_testc_si256 (y, x);
+  }
+#elif defined(__SSE2__)
+  {
+    __m128i x0 = _mm_loadu_si128 ((const __m128i *) a);
+    __m128i y0 = _mm_loadu_si128 ((const __m128i *) b);
+    __m128i x1 = _mm_loadu_si128 ((const __m128i *) (a + 2));
+    __m128i y1 = _mm_loadu_si128 ((const __m128i *) (b + 2));
+    __m128i z = _mm_or_si128 (_mm_andnot_si128 (y0, x0),
+                              _mm_andnot_si128 (y1, x1));
+    return _mm_movemask_epi8 (_mm_cmpeq_epi8 (z, _mm_setzero_si128 ()))
+           != 0xffff;
+  }
+#else
+  return ((a[0] & ~b[0]) | (a[1] & ~b[1]) |
+          (a[2] & ~b[2]) | (a[3] & ~b[3])) != 0;
+#endif
+}
+
 
 static int least_occuring_lit_without (int min, int offset) {
   int lit, tmp, i, best = INT_MAX, blit = 0;
@@ -1551,7 +1760,7 @@ static void watch_clause (Clause * clause) {
   fwsigs [ watched ] |= sig;
 }
 
-static int forward_subsumed_by_clause (Clause * clause, Sig sig) {
+static int forward_subsumed_by_clause (Clause * clause, const Sig * sig) {
   Node * p;
   int lit;
   Var * v;
@@ -1560,8 +1769,10 @@ static int forward_subsumed_by_clause (Clause * clause, Sig sig) {
 
   if (num_lits < clause->size) return 0;
   fw.sig1.lookups++;
-  if (clause->sig & ~sig) { fw.sig1.hits++; return 0; }
-  for (p = clause->nodes; (lit = p->lit); p++) {
+  if (wsig_excluded (clause->sig, sig)) { fw.sig1.hits++; return 0; }
+  if (sortlits) {
+    if (merge_lits (clause->nodes, lits, num_lits) != INT_MAX) return 0;
+  } else for (p = clause->nodes; (lit = p->lit); p++) {
     v = lit2var (lit);
     if (v->mark != lit) return 0;
   }
@@ -1662,14 +1873,11 @@ static Sig sig_lits2 (int * st, int size) {
   return res;
 }
 
-static Sig sig_lits (void) {
-  Sig res = 0ull;
-  int i, lit;
-  for (i = 0; i < num_lits; i++) {
-    lit = lits[i];
-    res |= lit2sig (lit);
-  }
-  return res;
+static void sig_lits (Sig * sig) {
+  int i;
+  memset (sig, 0, SIGWORDS * sizeof *sig);
+  for (i = 0; i < num_lits; i++)
+    lit2wsig (lits[i], sig);
 }
 
 
@@ -1679,18 +1887,18 @@ static int forward_subsumed (void) {
 
   Anchor * anchor;
   Clause * p;
-  Sig sig;
+  Sig sig[SIGWORDS];
   res = 0;
   mark_lits ();
-  sig = sig_lits ();
+  sig_lits (sig);
   for (i = 0; !res && i < num_lits; i++) {
     lit = lits[i];
     fw.sig2.lookups++;
-    if (!(fwsigs [ abs (lit) ] & sig)) { fw.sig2.hits++; continue; }
+    if (!(fwsigs [ abs (lit) ] & sig[0])) { fw.sig2.hits++; continue; }
     anchor = anchors + abs (lit);
     if (anchor->count > fwmaxoccs) continue;
     for (p = anchor->first; p; p = p->watch.next)
-      if ((res = forward_subsumed_by_clause (p, sig))) break;
+      if (p != fwskip && (res = forward_subsumed_by_clause (p, sig))) break;
   }
   unmark_lits ();
   if (res) {
@@ -1715,7 +1923,7 @@ static int forward_subsumed (void) {
   return res;
 }
 
-static int forward_strengthened_by_clause (Clause * clause, Sig sig) {
+static int forward_strengthened_by_clause (Clause * clause, const Sig * sig) {
   int lit, tmp, res;
 
   Node * p;
@@ -1724,7 +1932,11 @@ static int forward_strengthened_by_clause (Clause * clause, Sig sig) {
   if (clause->size > fwmax1size) return 0;
   if (num_lits < clause->size) return 0;
   fw.sig1.lookups++;
-  if (clause->sig & ~sig) { fw.sig1.hits++; return 0; }
+  if (wsig_excluded (clause->sig, sig)) { fw.sig1.hits++; return 0; }
+  if (sortlits) {
+    res = merge_lits (clause->nodes, lits, num_lits);
+    return res == INT_MAX ? 0 : res;
+  }
   res = 0;
   for (p = clause->nodes; (lit = p->lit); p++) {
     v = lit2var (lit);
@@ -1762,6 +1974,8 @@ static Clause * lookup_without_lit (int lit) {
 
   c = lookup_clause ();
   num_lits++;
+  lits[num_lits-1] = lits[pos];		/* keep '--sortlits' order */
+  lits[pos] = lit;
   return c;
 
 
@@ -1775,17 +1989,17 @@ static void forward_strengthen (void) {
   double start = seconds();
   Anchor * anchor;
   Clause * p;
-  Sig sig;
+  Sig sig[SIGWORDS];
   Var * v;
   if (num_lits > fwmax2size) return;
-  sig = sig_lits ();
+  sig_lits (sig);
   mark_lits ();
   res = 0;
 RESTART:
   for (i = 0; !res && i < num_lits; i++) {
     lit = lits[i];
     fw.sig2.lookups++;
-    if (!(fwsigs [ abs (lit) ] & sig)) { fw.sig2.hits++; continue; }
+    if (!(fwsigs [ abs (lit) ] & sig[0])) { fw.sig2.hits++; continue; }
     anchor = anchors + abs (lit);
     if (anchor->count > fwmaxoccs) continue;
     for (p = anchor->first; p; p = p->watch.next) {
@@ -1818,7 +2032,7 @@ RESTART:
       assert (k + 1 == num_lits);
       assert (found);
       num_lits--;
-      sig = sig_lits ();
+      sig_lits (sig);
       forward_strengthened_clauses++;
       strengthened_clauses++;
       goto RESTART;
@@ -1834,7 +2048,8 @@ static void add_clause (void) {
   int i;
   Var * v;
 
-  if (!substituting2) {
+  if (sortlits) sort_lits (lits, num_lits);
+  if (!substituting2 && !bulk_adding) {
     LOG("trying forward subsumption");
     if (forward_subsumed ()) {
       return;
@@ -1855,9 +2070,18 @@ static void add_clause (void) {
   INC (bytes);
   clause->count = 1;
   clause->size = num_lits;
+#ifndef NDEBUG
+  if (sortlits)
+    for (i = 1; i < num_lits; i++)
+      assert (cmp_sorted_lits (lits + i - 1, lits + i) <= 0);
+#endif
+  if (sortlits > 1 && num_lits) clause->maxorder = lit2order (lits[num_lits-1]);
+  else for (i = 0; i < num_lits; i++)
+    if (lit2order (lits[i]) > clause->maxorder)
+      clause->maxorder = lit2order (lits[i]);
   clause->prev = last_clause;
-  clause->sig = sig_lits ();;
-  LOG ("signature %016llx", clause->sig);
+  sig_lits (clause->sig);
+  LOG ("signature %016llx", clause->sig[0]);
   if (last_clause) last_clause->next = clause;
   else first_clause = clause;
   last_clause = clause;
@@ -1918,8 +2142,10 @@ static void delete_node (Node * node) {
     occ->last = node->prev;
   }
   occ->count--;
+  lit2var (node->lit)->touched = exp_epoch;
   LOG ("number of occurrences of %d decreased to %d", node->lit, occ->count);
-  update_score (abs (node->lit));
+  if (deferring_scores) defer_score (abs (node->lit));
+  else update_score (abs (node->lit));
 }
 
 static void dequeue (Clause * clause) {
@@ -2003,6 +2229,154 @@ static void push_literal (int lit) {
   lits[num_lits++] = lit;
 }
 
+/******** bulk clause insertion ***********/
+
+/* Clauses added in bulk are inserted without forward subsumption and
+ * strengthening and without touching the elimination schedule.  Then a
+ * single pass over the new clauses sorted by size removes those subsumed
+ * by another clause and strengthens the others.  At the end scores are
+ * updated and the schedule is rebuilt once instead of sifting a variable
+ * for every added literal.  Deleting a subsumed or strengthened clause
+ * may remove the last occurrence of a literal, since a subsumed clause is
+ * a superset of the subsuming one.  Scores are not updated during the
+ * batch, so pure literals are detected when the scores are flushed.
+ * The input file is parsed into 'bulk' as a whole, which costs one 'int'
+ * per literal and clause on top of the clauses until parsing ends.
+ * The buffer is released afterwards.
+ */
+
+typedef struct BulkClause { Clause * clause; int seq; } BulkClause;
+
+static void push_bulk (int lit) {
+  if (szbulk == nbulk) {
+    int new_size = szbulk ? 2*szbulk : 1;
+    RSZ (bulk, szbulk, new_size);
+    szbulk = new_size;
+  }
+  bulk[nbulk++] = lit;
+}
+
+static int cmp_bulk_clauses (const void * p, const void * q) {
+  const BulkClause * c = p, * d = q;
+  if (c->clause->size != d->clause->size)
+    return c->clause->size - d->clause->size;
+  return c->seq - d->seq;
+}
+
+static void subsume_bulk_clauses (Clause * old_last) {
+  BulkClause * sorted;
+  Clause * c;
+  Node * p;
+  int i, n;
+  n = 0;
+  for (c = old_last ? old_last->next : first_clause; c; c = c->next) n++;
+  if (!n) return;
+  NEWN (sorted, n);
+  i = 0;
+  for (c = old_last ? old_last->next : first_clause; c; c = c->next) {
+    sorted[i].clause = c;
+    sorted[i].seq = i;
+    i++;
+  }
+  qsort (sorted, n, sizeof *sorted, cmp_bulk_clauses);
+  for (i = 0; !empty_clause && i < n; i++) {
+    c = sorted[i].clause;
+    if (c->size < 2) continue;
+    assert (!num_lits);
+    for (p = c->nodes; p->lit; p++) push_literal (p->lit);
+    fwskip = c;
+    if (forward_subsumed ()) {
+      fwskip = 0;
+      qrat_lit = 0;
+      QRAT_TRACE_RATE_FROM_CLAUSE (c, "forward subsumed");
+      delete_clause (c);
+      bulk_subsumed_clauses++;
+      continue;
+    }
+    fwskip = 0;
+    for (p = c->nodes; p->lit; p++)
+      if (deref (p->lit)) break;
+    if (p->lit) { num_lits = 0; continue; }	/* left to 'flush_trail' */
+    forward_strengthen ();
+    if (num_lits < c->size) {
+      LOGCLAUSE (c, "replacing bulk strengthened");
+      add_clause ();
+      delete_clause (c);
+      bulk_strengthened_clauses++;
+    } else num_lits = 0;
+  }
+  DELN (sorted, n);
+}
+
+static void flush_deferred_scores (void) {
+  int i, idx, rebuild, pos, neg;
+  Var * v;
+  assert (!deferring_scores);
+  rebuild = (4*ndirty >= size_schedule);
+  for (i = 0; i < ndirty; i++) {
+    idx = dirty[i];
+    v = lit2var (idx);
+    assert (v->dirty);
+    v->dirty = 0;
+    pos = v->occs[0].count;
+    neg = v->occs[1].count;
+    v->score = pos + neg;
+    if (!empty_clause && idx != elimidx && isfree (idx)) {
+      if (pos && !neg) {
+	if (existential (idx)) unet (idx); else unate (idx);
+      } else if (neg && !pos) {
+	if (existential (idx)) unet (-idx); else unate (-idx);
+      }
+    }
+    if (v->pos < 0) {
+      if (deref (idx) || idx == elimidx) continue;
+      if (!rebuild) { push_schedule (idx); continue; }
+      assert (size_schedule < num_vars);
+      schedule[v->pos = size_schedule++] = idx;
+      pushed_vars++;
+    } else if (!rebuild) { up (idx); down (idx); }
+  }
+  if (rebuild) {
+    LOG ("rebuilding schedule after %d score updates", ndirty);
+    for (i = size_schedule/2 - 1; i >= 0; i--)
+      down (schedule[i]);
+  }
+  ndirty = 0;
+}
+
+/* Add the 0 terminated clauses in 'clauses[0..n-1]'.  With 'mode' 1 the
+ * clauses come from the input file, with 'mode' 2 they are resolvents.
+ * Literals after the last 0 are ignored.  Returns the number of clauses
+ * consumed, which is less than given if the empty clause was found.
+ */
+static int add_clauses (const int * clauses, size_t n, int mode) {
+  Clause * old_last = last_clause;
+  int lit, res;
+  size_t i;
+  assert (!num_lits);
+  assert (!bulk_adding && !deferring_scores);
+  bulk_batches++;
+  bulk_adding = deferring_scores = 1;
+  res = 0;
+  for (i = 0; !empty_clause && i < n; i++) {
+    lit = clauses[i];
+    if (lit) { push_literal (lit); continue; }
+    res++;
+    if (mode == 2) {
+      if (lookup_clause ()) { num_lits = 0; continue; }
+      QRAT_TRACE_RATA_FROM_STACK0("var elimination");
+    }
+    if (trivial_clause_ (mode == 1)) num_lits = 0;
+    else add_clause ();
+  }
+  num_lits = 0;
+  bulk_adding = 0;
+  if (!empty_clause) subsume_bulk_clauses (old_last);
+  deferring_scores = 0;
+  flush_deferred_scores ();
+  return res;
+}
+
 static void log_declared_scopes (void) {
   int count, o, c;
   Scope * p;
@@ -2436,22 +2810,16 @@ NEXT:
                        &remaining_clauses_to_parse);
      }
      if (lit) lit *= sign, c++; else i++, remaining_clauses_to_parse--;
-     if (lit) push_literal (lit);
-     else {
-       if (!empty_clause && !trivial_clause_ (1)) {
-	 add_clause ();
-	 if (empty_clause) {
-	   orig_clauses = i;
-	   goto DONE;
-	 }
-       } else {
-         num_lits = 0;
-       }       
-      }
+     push_bulk (lit);
    }
    goto NEXT;
 DONE:
   if (started) stop_progress ();
+  j = add_clauses (bulk, nbulk, 1);
+  if (empty_clause) orig_clauses = j;
+  DELN (bulk, szbulk);
+  szbulk = nbulk = 0;
+  bulk = 0;
   parseTime = seconds() - start;
   msg ("read %d literals in %.1f seconds", c, parseTime);
   if (verbose) log_pruned_scopes ();
@@ -2761,7 +3129,218 @@ static int pop_schedule (void) {
 }
 
 
-static int block_clause_aux (int pivot) {
+/******** dependency schemes ***********/
+
+/* The standard dependency scheme lets an existential 'e' depend on a
+ * universal 'u' preceding it, if they are connected through clauses and
+ * existential variables to the right of 'u'.  The order of the innermost
+ * universal scope each existential depends on is kept in 'maxdep' (-1 if
+ * none).  An existential with 'maxdep[e] < order' can be moved outward
+ * into scope 'order'.  Since removing clauses or literals, as well as the
+ * resolvents of eliminations relying on such moves, do not add
+ * dependencies, the prefix may be treated that way in blocking and
+ * mini-scoping until the next computation.  The components for each
+ * universal scope are built with union-find, from the inner most scope
+ * outward, by uniting the existentials of a clause with its innermost one.
+ * Dependencies are only computed for and valid during 'elim' and are not
+ * used while tracing QRAT, which checks against the original prefix.
+ */
+
+static int * maxdep, szmaxdep, depvalid;
+
+static int dep_find (int * dsu, int idx) {
+  int res, tmp;
+  for (res = idx; dsu[res] != res; res = dsu[res])
+    ;
+  while (idx != res) tmp = dsu[idx], dsu[idx] = res, idx = tmp;
+  return res;
+}
+
+static int cmp_dep_edges (const void * p, const void * q) {
+  return lit2order (*(const int *) q) - lit2order (*(const int *) p);
+}
+
+static int dep_inner (Clause * c, int order) {
+  int lit, res = 0;
+  Node * p;
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (existential (lit) && lit2order (lit) > order &&
+        (!res || lit2order (lit) > lit2order (res)))
+      res = abs (lit);
+  return res;
+}
+
+static void compute_std_deps (void) {
+  int idx, lit, inner, i, order, * dsu, * stamp;
+  double start;
+  Scope * s, * t;
+  Clause * c;
+  Node * p;
+  Var * v;
+  start = seconds ();
+  dep_computations++;
+  if (szmaxdep <= num_vars) {
+    RSZ (maxdep, szmaxdep, num_vars + 1);
+    szmaxdep = num_vars + 1;
+  }
+  NEWN (dsu, num_vars + 1);
+  NEWN (stamp, num_vars + 1);
+  for (idx = 0; idx <= num_vars; idx++)
+    dsu[idx] = idx, stamp[idx] = maxdep[idx] = -1;
+  assert (!naux);
+  for (c = first_clause; c; c = c->next) {
+    if (!(inner = dep_inner (c, -1))) continue;
+    for (p = c->nodes; (lit = p->lit); p++)
+      if (existential (lit) && abs (lit) != inner)
+	push_aux (abs (lit)), push_aux (inner);
+  }
+  qsort (aux, naux / 2, 2 * sizeof *aux, cmp_dep_edges);
+  i = 0;
+  for (s = inner_most_scope; s; s = s->outer) {
+    if (s->type > 0) continue;
+    order = s->order;
+    for (; i < naux && lit2order (aux[i]) > order; i += 2)
+      dsu[dep_find (dsu, aux[i])] = dep_find (dsu, aux[i + 1]);
+    for (v = s->first; v; v = v->next)
+      for (lit = -(v - vars); lit <= v - vars; lit += 2 * (v - vars))
+	for (p = lit2occ (lit)->first; p; p = p->next)
+	  if ((inner = dep_inner (p->clause, order)))
+	    stamp[dep_find (dsu, inner)] = order;
+    for (t = s->inner; t; t = t->inner) {
+      if (t->type < 0) continue;
+      for (v = t->first; v; v = v->next) {
+	idx = v - vars;
+	if (maxdep[idx] < 0 && stamp[dep_find (dsu, idx)] == order)
+	  maxdep[idx] = order;
+      }
+    }
+  }
+  naux = 0;
+  DELN (stamp, num_vars + 1);
+  DELN (dsu, num_vars + 1);
+  depvalid = num_vars;
+  depTime += seconds () - start;
+}
+
+static void std_deps (void) {
+  depvalid = 0;
+  if (depscheme < 1 || qrat_file || partial_assignment) return;
+  compute_std_deps ();
+}
+
+/* Existential 'lit' may be treated as if it were in scope 'order'.
+ */
+static int dep_movable (int lit, int order) {
+  int idx = abs (lit);
+  if (!depvalid || idx > depvalid || !existential (lit)) return 0;
+  return maxdep[idx] < order;
+}
+
+/* All literals to the right of the existential 'idx' in its clauses can
+ * be moved to its scope, so it can be mini-scoped and resolved away.
+ */
+static int dep_miniscope (int idx) {
+  int order, sign, lit, res;
+  Node * p, * q;
+  if (!depvalid) return 0;
+  order = lit2order (idx);
+  res = 0;
+  for (sign = -1; sign <= 1; sign += 2)
+    for (p = lit2occ (sign * idx)->first; p; p = p->next) {
+      if (p->clause->maxorder <= order) continue;
+      for (q = p->clause->nodes; (lit = q->lit); q++)
+	if (lit2order (lit) > order && !dep_movable (lit, order)) return 0;
+      res = 1;
+    }
+  return res;
+}
+
+/* With '--reorder' the dependencies are realized in the prefix itself.
+ * Each existential is shifted out into the existential scope following
+ * the innermost universal scope it depends on.  The result is the linear
+ * prefix closest to the non-linear one given by 'maxdep', and it is also
+ * the one printed.  Fewer existentials stay right of each universal,
+ * which shrinks expansion cones.  Clauses with shifted variables are
+ * re-added, which reduces universal literals now innermost.  The standard
+ * dependencies are computed for this even with '--depscheme=0'.
+ */
+static void move_var (Var * v, Scope * scope) {
+  Scope * s = v->scope;
+  assert (s != scope);
+  if (v->prev) v->prev->next = v->next; else s->first = v->next;
+  if (v->next) v->next->prev = v->prev; else s->last = v->prev;
+  assert (s->free > 0);
+  s->free--;
+  v->scope = 0;
+  add_var (v - vars, scope);
+}
+
+static int reorder_prefix (void) {
+  int idx, order, lit, res, i, n, m, sign;
+  Clause * c, ** clauses;
+  double start;
+  Scope * s, * t;
+  Var * v, * w;
+  Node * p;
+  if (!reorder || qrat_file || partial_assignment) return 0;
+  compute_std_deps ();
+  start = seconds ();
+  reorders++;
+  assert (!nstack);
+  for (s = outer_most_scope->inner; s; s = s->inner) {
+    if (s->type < 0) continue;
+    for (v = s->first; v; v = w) {
+      w = v->next;
+      if (v->tag != FREE) continue;
+      idx = v - vars;
+      order = maxdep[idx] + 1;
+      if (order >= s->order) continue;
+      for (t = outer_most_scope; t->order < order; t = t->inner)
+	;
+      assert (t->type > 0);
+      LOG ("shifting existential %d from scope %d to scope %d",
+           idx, s->order, order);
+      move_var (v, t);
+      push_stack (idx);
+    }
+  }
+  depvalid = 0;
+  res = nstack;
+  if (res) {
+    reordered_vars += res;
+    exp_valid_epoch = exp_epoch;
+    expansion_cost_mark++;
+    m = num_clauses;
+    NEWN (clauses, m);
+    n = 0;
+    for (i = 0; i < nstack; i++)
+      for (sign = -1; sign <= 1; sign += 2)
+	for (p = lit2occ (sign * stack[i])->first; p; p = p->next) {
+	  c = p->clause;
+	  if (c->mark == expansion_cost_mark) continue;
+	  c->mark = expansion_cost_mark;
+	  clauses[n++] = c;
+	}
+    nstack = 0;
+    reordered_clauses += n;
+    for (i = 0; !empty_clause && i < n; i++) {
+      c = clauses[i];
+      for (p = c->nodes; (lit = p->lit); p++) push_literal (lit);
+      LOGCLAUSE (c, "re-adding reordered");
+      bulk_adding = 1;		/* would be subsumed by 'c' itself */
+      add_clause ();
+      bulk_adding = 0;
+      delete_clause (c);
+    }
+    DELN (clauses, m);
+  }
+  depTime += seconds () - start;
+  return res;
+}
+
+static int dep_clash;		/* clash only on a movable literal */
+
+static int block_clause_aux (int pivot, int deps) {
   int res, lit, tmp, porder, lorder;
 #ifndef NDEBUG
   int found;
@@ -2783,11 +3362,17 @@ static int block_clause_aux (int pivot) {
     LOGCLAUSE (other, "try to resolve on %d with other clause", pivot);
     for (q = other->nodes; (lit = q->lit); q++) {
       if (lit == -pivot) { assert (p == q); assert ((found = 1)); continue; }
-      lorder = lit2scope (lit)->order;
-      if (lorder > porder) continue;//TODO triangle dependencies?
+      lorder = 0;
+      if (other->maxorder > porder) {
+	lorder = lit2scope (lit)->order;
+	if (lorder > porder && !(deps && dep_movable (lit, porder))) {
+	  if (sortlits > 1 && !deps) { lit = 0; break; }	/* only inner ones left */
+	  continue;
+	}
+      }
       v = lit2var (lit);
       tmp = v->mark;
-      if (tmp == -lit) break;
+      if (tmp == -lit) { if (lorder > porder) dep_clash = 1; break; }
     }
     assert (lit || found);
     if (lit) LOG ("other clause produces trivial resolvent on %d", lit);
@@ -2804,8 +3389,10 @@ static int block_clause (Clause * clause, int pivot) {
   if (occ->count > blkmax1occs) return 0;
   LOGCLAUSE (clause, "check whether literal %d blocks clause", pivot);
   mark_clause (clause);
-  res = block_clause_aux (pivot);
+  dep_clash = 0;
+  res = block_clause_aux (pivot, depvalid);
   unmark_clause (clause);
+  if (res && dep_clash) dep_blocked++;
   return res;
 }
 
@@ -2859,8 +3446,162 @@ static void block_lit (int lit) {
   bceTime += (seconds() - start);
 }
 
+/******** gate detection ***********/
+
+static Clause * find_ternary (int a, int b, int c) {
+  Node * p;
+  Clause * clause;
+  int lit, found;
+  for (p = lit2occ (a)->first; p; p = p->next) {
+    clause = p->clause;
+    if (clause->size != 3) continue;
+    found = 0;
+    for (lit = 0; lit < 3; lit++)
+      if (clause->nodes[lit].lit == b || clause->nodes[lit].lit == c)
+	found++;
+    if (found == 2) return clause;
+  }
+  return 0;
+}
+
+static void gate_clause (Clause * clause) {
+  if (clause->gate) return;
+  clause->gate = 1;
+  gate_clauses++;
+}
+
+static int find_and_gate (int lit) {
+  Node * p, * q, * r;
+  Clause * c, * d;
+  int other, res = 0;
+  for (p = lit2occ (-lit)->first; p; p = p->next) {
+    c = p->clause;
+    if (c->size != 2) continue;
+    other = c->nodes[c->nodes[0].lit == -lit].lit;
+    if (!lit2var (other)->mark) lit2var (other)->mark = other;
+  }
+  for (p = lit2occ (lit)->first; !res && p; p = p->next) {
+    c = p->clause;
+    for (r = c->nodes; (other = r->lit); r++)
+      if (other != lit && lit2var (other)->mark != -other) break;
+    if (other) continue;
+    gate_clause (c);
+    for (q = lit2occ (-lit)->first; q; q = q->next) {
+      d = q->clause;
+      if (d->size != 2) continue;
+      other = d->nodes[d->nodes[0].lit == -lit].lit;
+      for (r = c->nodes; r->lit && r->lit != -other; r++)
+	;
+      if (r->lit) gate_clause (d);
+    }
+    res = (c->size == 2) ? EQUIV_GATE : AND_GATE;
+  }
+  for (p = lit2occ (-lit)->first; p; p = p->next) {
+    c = p->clause;
+    if (c->size != 2) continue;
+    other = c->nodes[c->nodes[0].lit == -lit].lit;
+    lit2var (other)->mark = 0;
+  }
+  return res;
+}
+
+static void other_lits (Clause * clause, int lit, int * a, int * b) {
+  Node * p;
+  *a = *b = 0;
+  for (p = clause->nodes; p->lit; p++)
+    if (p->lit == lit) continue;
+    else if (*a) *b = p->lit;
+    else *a = p->lit;
+}
+
+static int find_xor_gate (int idx) {
+  Clause * c, * d, * e, * f;
+  int a, b;
+  Node * p;
+  for (p = lit2occ (idx)->first; p; p = p->next) {
+    c = p->clause;
+    if (c->size != 3) continue;
+    other_lits (c, idx, &a, &b);
+    if (!(d = find_ternary (idx, -a, -b))) continue;
+    if (!(e = find_ternary (-idx, a, -b))) continue;
+    if (!(f = find_ternary (-idx, -a, b))) continue;
+    gate_clause (c), gate_clause (d), gate_clause (e), gate_clause (f);
+    return XOR_GATE;
+  }
+  return NO_GATE;
+}
+
+static int find_ite_gate (int idx) {
+  int a, b, x, y, cond, then, other, i;
+  Clause * c, * d, * e, * f;
+  Node * p, * q;
+  for (p = lit2occ (-idx)->first; p; p = p->next) {
+    c = p->clause;
+    if (c->size != 3) continue;
+    other_lits (c, -idx, &a, &b);
+    for (i = 0; i < 2; i++) {
+      cond = i ? -b : -a;		/* c = (-idx | -cond | then) */
+      then = i ? a : b;
+      if (!(d = find_ternary (idx, -cond, -then))) continue;
+      for (q = lit2occ (-idx)->first; q; q = q->next) {
+	e = q->clause;
+	if (e == c || e->size != 3) continue;
+	other_lits (e, -idx, &x, &y);	/* e = (-idx | cond | other) */
+	if (x == cond) other = y;
+	else if (y == cond) other = x;
+	else continue;
+	if (!(f = find_ternary (idx, cond, -other))) continue;
+	gate_clause (c), gate_clause (d), gate_clause (e), gate_clause (f);
+	return ITE_GATE;
+      }
+    }
+  }
+  return NO_GATE;
+}
+
+/* Look for a definition of the existential 'idx' in terms of other
+ * variables and mark its clauses as gate clauses.  Resolvents among gate
+ * clauses are tautological and resolvents among non-gate clauses are
+ * implied by the remaining ones, thus only gate clauses have to be
+ * resolved against non-gate clauses.  We only use gates if all clauses of
+ * 'idx' can be mini-scoped, i.e. if 'idx' is innermost in all of them.
+ * The non-gate resolvents of AND gates and equivalences are asymmetric
+ * tautologies, which is not the case for XOR and ITE gates, so the latter
+ * are not used while tracing QRAT.
+ */
+static int find_gate (int idx) {
+  int order, res, sign;
+  Node * p;
+  assert (idx > 0);
+  assert (existential (idx));
+  assert (!gate_clauses);
+  if (!gates) return NO_GATE;
+  order = lit2order (idx);
+  if (!dep_miniscope (idx))
+    for (sign = -1; sign <= 1; sign += 2)
+      for (p = lit2occ (sign * idx)->first; p; p = p->next)
+	if (p->clause->maxorder > order) return NO_GATE;
+  res = find_and_gate (idx);
+  if (!res) res = find_and_gate (-idx);
+  if (!res && !qrat_file) res = find_xor_gate (idx);
+  if (!res && !qrat_file) res = find_ite_gate (idx);
+  if (res) LOG ("found %d gate clauses of type %d for %d",
+		gate_clauses, res, idx);
+  return res;
+}
+
+static void reset_gate (int idx) {
+  int sign;
+  Node * p;
+  if (!gate_clauses) return;
+  for (sign = -1; sign <= 1; sign += 2)
+    for (p = lit2occ (sign * idx)->first; p; p = p->next)
+      p->clause->gate = 0;
+  gate_clauses = 0;
+}
+
 static int try_to_resolve_away (int limit) {
-  int elimidx_order, lit_order, lit, mini_scope, count, nontriv,  res;
+  int elimidx_order, lit_order, lit, mini_scope, count, nontriv,  res, relaxed;
   int clash = 0, nonstrictve = 0;
   double start;
   Node * p, * q, * r;
@@ -2874,6 +3615,7 @@ static int try_to_resolve_away (int limit) {
   if (!ve) return 0;
   start = seconds();
   elimidx_order = lit2scope (elimidx)->order;
+  relaxed = dep_miniscope (elimidx);
   nontriv = count = 0;
   pocc = lit2occ (elimidx);
   nocc = lit2occ (-elimidx);
@@ -2889,22 +3631,28 @@ static int try_to_resolve_away (int limit) {
 	 q = q->next) {
       count++;
       d = q->clause;
+      if (gate_clauses && c->gate == d->gate) continue;
       if (d->size > elimsize) { nontriv = INT_MAX-1; continue; }
       LOGCLAUSE (c, "%d:%d/%d elimination %d clause",
                 count, nontriv + 1, limit, elimidx);
       LOGCLAUSE (d, "%d:%d/%d elimination %d clause",
 		 count, nontriv + 1, limit, -elimidx);
       clash =  0;
+      if (!relaxed && d->maxorder > elimidx_order) {
+	if (mini_scope)
+	  LOG ("clause with scope %d prevents mini-scoping", d->maxorder);
+	mini_scope = 0;
+      }
       for (r = d->nodes; (lit = r->lit); r++) {
 	if (lit == -elimidx) { continue; }
-	lit_order = lit2scope (lit)->order;
-	if (lit_order > elimidx_order) { 
-	  if (mini_scope) 
-	    LOG ("literal %d in scope %d prevents mini-scoping", 
-	         lit, lit_order);
-	  mini_scope = 0; 
-	} else if (clash) continue;
-	else if (lit2var (lit)->mark == -lit) clash = lit;
+	if (!relaxed && d->maxorder > elimidx_order) {
+	  lit_order = lit2scope (lit)->order;
+	  if (lit_order > elimidx_order) {
+	    if (sortlits > 1) break;		/* only inner ones left */
+	    continue;
+	  }
+	}
+	if (lit2var (lit)->mark == -lit) { clash = lit; break; }
       }
       // COVER (clash && !mini_scope);
       if (clash) {
@@ -2964,6 +3712,7 @@ static int try_to_resolve_away (int limit) {
     res = 0;
   }
   if (res && nonstrictve) nonstrictves++;
+  if (res && relaxed) dep_eliminated++;
   veTime += (seconds() - start);
   return res;
 }
@@ -2977,26 +3726,25 @@ static void resolve_away (int idx) {
   assert (!deref (elimidx));
   assert (trail_flushed ());
   LOG ("RESOLVING away %d", elimidx);
+  assert (!nbulk);
   for (p = lit2occ (elimidx)->first; p; p = p->next) {
     c = p->clause;
     for (q = lit2occ (-elimidx)->first; q; q = q->next) {
       d = q->clause;
-      assert (!num_lits);
+      if (gate_clauses && c->gate == d->gate) continue;
       LOGCLAUSE (c, "%d antecedent", elimidx);
       for (r = c->nodes; (lit = r->lit); r++)
 	if (abs (lit) != elimidx)
-	  push_literal (lit);
+	  push_bulk (lit);
       LOGCLAUSE (d, "%d antecedent", -elimidx);
       for (r = d->nodes; (lit = r->lit); r++)
 	if (abs (lit) != elimidx)
-	  push_literal (lit);
-      if (!lookup_clause ()) {
-        QRAT_TRACE_RATA_FROM_STACK0("var elimination");
-        if (trivial_clause ()) { LOG ("resolvent is trivial"); num_lits = 0; }
-        else { LOG ("non-trivial"); add_clause (); }
-      } else num_lits = 0;
+	  push_bulk (lit);
+      push_bulk (0);
     }
   }
+  add_clauses (bulk, nbulk, 2);
+  nbulk = 0;
   LOG ("deleting clauses with %d", elimidx);
   for (p = lit2occ (elimidx)->first; p; p = next) {
     next = p->next;
@@ -3019,29 +3767,44 @@ static void resolve_away (int idx) {
   LOG ("eliminated %d remaining %d", elimidx, remaining);
 }
 
-static void elim_idx (int idx) {
-  int limit;
+static int elim_limit (int idx) {
+  int limit = lit2occ (idx)->count + lit2occ (-idx)->count;
+  if (limit > elimoccs) return -1;
+  limit += excess;
+  LOG ("TRYING to eliminate %d clauses with idx %d in scope %d", 
+       limit, idx, lit2scope (idx)->order);
+  return limit;
+}
+
+static int block_idx (int idx) {
   assert (0 < idx);
   assert (!deref (idx));
   assert (!elimidx);
   if(bce) LOG ("TRYING to block clauses on idx %d", idx);
   block_lit (idx);
-  if (trail_flushed ()) {
-    block_lit (-idx);
-    if (trail_flushed ()) {
-      limit = lit2occ (idx)->count + lit2occ (-idx)->count;
-      if (limit <= elimoccs) {
-	limit += excess;
-	LOG ("TRYING to eliminate %d clauses with idx %d in scope %d", 
-	     limit, idx, lit2scope (idx)->order);
-	assert (!elimidx);
-	elimidx = idx;
-	if (try_to_resolve_away (limit)) resolve_away (idx);
-	assert (elimidx == idx);
-	elimidx = 0;
-      }
-    }
+  if (!trail_flushed ()) return -1;
+  block_lit (-idx);
+  if (!trail_flushed ()) return -1;
+  return elim_limit (idx);
+}
+
+static void resolve_idx (int idx, int limit) {
+  int gate;
+  assert (!elimidx);
+  elimidx = idx;
+  gate = ve ? find_gate (idx) : NO_GATE;
+  if (try_to_resolve_away (limit)) {
+    if (gate) gate_eliminations++, gate_types[gate]++;
+    resolve_away (idx);
   }
+  reset_gate (idx);
+  assert (elimidx == idx);
+  elimidx = 0;
+}
+
+static void elim_idx (int idx) {
+  int limit = block_idx (idx);
+  if (limit >= 0) resolve_idx (idx, limit);
 }
 
 static int backward_subsumes (Clause * clause, Clause * other) {
@@ -3053,7 +3816,8 @@ static int backward_subsumes (Clause * clause, Clause * other) {
   if (other->size > bwmax2size) return 0;
   if (clause->size >= other->size) return 0;
   bw.sig1.lookups++;
-  if (clause->sig & ~other->sig) { bw.sig1.hits++; return 0; }
+  if (wsig_excluded (clause->sig, other->sig)) { bw.sig1.hits++; return 0; }
+  if (sortlits) return merge_nodes (clause->nodes, other->nodes) == INT_MAX;
   count = clause->size;
   except = other->size - count;
   for (p = other->nodes; except >= 0 && (lit = p->lit); p++)
@@ -3073,7 +3837,11 @@ static int backward_self_subsumes (Clause * clause, Clause * other) {
   if (other->size > bwmax2size) return 0;
   if (clause->size > other->size) return 0;
   bw.sig1.lookups++;
-  if (clause->sig & ~other->sig) { bw.sig1.hits++; return 0; }
+  if (wsig_excluded (clause->sig, other->sig)) { bw.sig1.hits++; return 0; }
+  if (sortlits) {
+    res = merge_nodes (clause->nodes, other->nodes);
+    return res == INT_MAX ? 0 : res;
+  }
   count = clause->size;
   except = other->size - count;
   res = 0;
@@ -3174,10 +3942,10 @@ static void backward (Clause * clause) {
   sig = ~0llu;
   for (p = clause->nodes; (lit = p->lit); p++)
     sig &= bwsigs [ abs (lit) ];
-  LOG ("clause sig2  %016llx", clause->sig);
+  LOG ("clause sig2  %016llx", clause->sig[0]);
   LOG ("intersection %016llx", sig);
   bw.sig2.lookups++;
-  if (clause->sig & ~sig) { bw.sig2.hits++; goto DONE; }
+  if (clause->sig[0] & ~sig) { bw.sig2.hits++; goto DONE; }
   LOGCLAUSE (clause, "backward subsumption with clause");
   submark_clause (clause);
   occ = lit2occ (first);
@@ -3225,7 +3993,7 @@ LOG ("double backward self subsumption strengthens subsuming clause");
 DONE:
   assert (clause);
   for (p = clause->nodes; (lit = p->lit); p++)
-    bwsigs [ abs (lit) ] |= clause->sig;
+    bwsigs [ abs (lit) ] |= clause->sig[0];
 }
 
 static void enlarge_stack (void) {
@@ -3464,7 +4232,7 @@ DONE:
       LOG ("check whether literal %d blocks extended clause", lit);
       
       if (existential (lit) || !red_lit) {
-        redundant = block_clause_aux (lit);
+        redundant = block_clause_aux (lit, 0);
       }
       if (universal (lit) && redundant && !red_lit) {
         redundant = 0;
@@ -3634,42 +4402,1170 @@ static void flush_queue (int outer) {
   if (verbose) log_pruned_scopes ();
 }
 
-static int pop_literal (void) {
-  assert (num_lits > 0);
-  return lits[--num_lits];
-}
+/******** global subsumption ***********/
 
-static void dfs_clean (void) {
-  memset (dfsi - num_vars, 0, (2*num_vars + 1) * sizeof *dfsi);
-  memset (mindfsi - num_vars, 0, (2*num_vars + 1) * sizeof *mindfsi);
-  memset (repr - num_vars, 0, (2*num_vars + 1) * sizeof *repr);
-}
+/* One-shot subsumption and strengthening over all clauses.  Copies of the
+ * clauses with literals sorted by variable are checked in the order of
+ * increasing size against the already checked ones, which are connected
+ * only through their least occurring literal.  A clause D subsumes or
+ * strengthens C only if D is not larger, and then C contains the watched
+ * literal of D or its negation, so it suffices to traverse the lists of
+ * all literals of C and their negations.  The checks themselves merge the
+ * sorted literals.  Strengthened clauses are replaced after the round.
+ */
 
-static int cmporder (int a, int b) {
-  int res;
-  if ((res = lit2order (a) - lit2order (b))) return res;
+typedef struct SubClause {
+  Clause * clause;
+  int start, size, seq, next;
+  Sig vsig;			/* signature over variables */
+} SubClause;
+
+static int cmp_sub_lits (const void * p, const void * q) {
+  int a = *(const int *) p, b = *(const int *) q, res;
   if ((res = abs (a) - abs (b))) return res;
-  return b - a;
+  return a - b;
 }
 
-static int subst_clause (Clause * c) {
-  int lit, tmp, res;
-  Node * p;
-  assert (!num_lits);
-  res = 0;
+static int cmp_sub_clauses (const void * p, const void * q) {
+  const SubClause * c = p, * d = q;
+  if (c->size != d->size) return c->size - d->size;
+  return c->seq - d->seq;
+}
 
-  LOGCLAUSE(c, "trying subst clause");
-  for (p = c->nodes; (lit = p->lit); p++) {
-    tmp = repr[lit];
-    if (partial_assignment && vars[abs(tmp)].scope->order == assigned_scope) 
-      tmp = lit;
-    assert (tmp);
-    if (tmp != lit) {
-      res = 1;
+/* Returns INT_MAX if 'd' subsumes 'c', the literal of 'c' to remove if
+ * 'd' strengthens 'c', and zero otherwise.
+ */
+static int subsume_check (const int * d, int m, const int * c, int n) {
+  int i = 0, j = 0, res = INT_MAX;
+  while (i < m) {
+    if (n - j < m - i) return 0;
+    if (abs (c[j]) < abs (d[i])) { j++; continue; }
+    if (abs (c[j]) > abs (d[i])) return 0;
+    if (c[j] != d[i]) {
+      if (res != INT_MAX) return 0;
+      res = c[j];
     }
-    push_literal (tmp);
+    i++, j++;
   }
-  if (!res) { num_lits = 0; return 0; }
+  return res;
+}
+
+static void subsume_round (void) {
+  int i, j, k, n, size, lit, other, pivot, nsublits, * sublits, * heads;
+  int64_t steps;
+  SubClause * subs, * c, * d;
+  double start;
+  Clause * p;
+  Node * q;
+  if (!subsume || empty_clause) return;
+  start = seconds ();
+  subsume_rounds++;
+  n = nsublits = 0;
+  for (p = first_clause; p; p = p->next) {
+    if (p->size < 2) continue;
+    n++;
+    nsublits += p->size;
+  }
+  if (!n) return;
+  NEWN (subs, n);
+  NEWN (sublits, nsublits);
+  NEWN (heads, 2*num_vars + 1);
+  heads += num_vars;
+  for (i = -num_vars; i <= num_vars; i++) heads[i] = -1;
+  i = nsublits = 0;
+  for (p = first_clause; p; p = p->next) {
+    if (p->size < 2) continue;
+    c = subs + i;
+    c->clause = p;
+    c->start = nsublits;
+    c->size = p->size;
+    c->seq = i++;
+    for (q = p->nodes; (lit = q->lit); q++) {
+      sublits[nsublits++] = lit;
+      c->vsig |= lit2sig (abs (lit));
+    }
+    qsort (sublits + c->start, c->size, sizeof *sublits, cmp_sub_lits);
+  }
+  qsort (subs, n, sizeof *subs, cmp_sub_clauses);
+  steps = 0;
+  assert (!naux);
+  for (i = 0; !empty_clause && i < n && steps < substeps; i++) {
+    c = subs + i;
+    for (j = 0; j < c->size; j++)
+      if (deref (sublits[c->start + j])) break;
+    if (j < c->size) continue;			/* left to 'flush_trail' */
+    pivot = 0;
+    for (j = 0; !pivot && j < 2*c->size; j++) {
+      lit = sublits[c->start + j/2];
+      if (j & 1) lit = -lit;
+      for (k = heads[lit]; k >= 0; k = d->next) {
+	d = subs + k;
+	steps++;
+	if (d->vsig & ~c->vsig) continue;
+	steps += d->size;
+	pivot = subsume_check (sublits + d->start, d->size,
+			       sublits + c->start, c->size);
+	if (pivot) break;
+      }
+    }
+    if (pivot == INT_MAX) {
+      LOGCLAUSE (c->clause, "globally subsumed");
+      LOGCLAUSE (d->clause, "globally subsuming");
+      qrat_lit = 0;
+      QRAT_TRACE_RATE_FROM_CLAUSE (c->clause, "global subsumption");
+      delete_clause (c->clause);
+      subsumed_clauses++;
+      round_subsumed_clauses++;
+      continue;
+    }
+    if (pivot) {
+      LOGCLAUSE (c->clause, "globally strengthened on %d", pivot);
+      push_aux (c - subs);
+      push_aux (pivot);
+      continue;
+    }
+    lit = sublits[c->start];
+    for (j = 1; j < c->size; j++) {
+      other = sublits[c->start + j];
+      if (lit2occ (other)->count < lit2occ (lit)->count) lit = other;
+    }
+    c->next = heads[lit];
+    heads[lit] = c - subs;
+  }
+  for (i = 0; i < naux; i += 2) {
+    c = subs + aux[i];
+    pivot = aux[i + 1];
+    assert (!num_lits);
+    for (j = 0; j < c->size; j++)
+      if (deref (sublits[c->start + j])) break;
+    if (j < c->size) continue;			/* left to 'flush_trail' */
+    for (j = 0; j < c->size; j++)
+      if ((lit = sublits[c->start + j]) != pivot) push_literal (lit);
+    size = num_lits;
+    if (!lookup_clause ()) {
+      QRAT_TRACE_RATA_FROM_STACK0 ("global strengthening");
+    } else size = 0;
+    strengthened_clauses++;
+    round_strengthened_clauses++;
+    if (!size || trivial_clause ()) num_lits = 0;
+    else add_clause ();
+    qrat_lit = 0;
+    QRAT_TRACE_RATE_FROM_CLAUSE (c->clause, "global strengthening");
+    delete_clause (c->clause);
+    if (empty_clause) break;
+  }
+  naux = 0;
+  heads -= num_vars;
+  DELN (heads, 2*num_vars + 1);
+  DELN (sublits, nsublits);
+  DELN (subs, n);
+  subsTime += (seconds () - start);
+  if (verbose > 1)
+    msg ("subsumption round %d in %.2f seconds after %lld steps",
+	 subsume_rounds, seconds () - start, (long long) steps);
+}
+
+/******** unhiding ***********/
+
+/* Unhiding stamps the binary implication graph, with edges -a -> b and
+ * -b -> a for every binary clause (a | b), by a randomized depth first
+ * search.  A literal with discovery and finish stamps nested within
+ * those of another one is implied by it through tree edges only.  Then
+ * hidden tautologies, hidden literals, failed literals and transitive
+ * binary clauses are found with a few sorted scans per clause.  All steps
+ * keep the matrix propositionally equivalent, thus universal literals
+ * need no special care beyond the universal reduction in 'add_clause'.
+ * Binary clauses are only removed as transitive if none of their two
+ * edges is a tree edge, since tree edges justify all other steps.
+ */
+
+static int * uh_dsc, * uh_fin, * uh_prt;
+static Node ** uh_next;
+static unsigned uh_seed;
+
+static int uh_descendant (int a, int b) {	/* 'b' below 'a' */
+  return uh_dsc[a] < uh_dsc[b] && uh_fin[b] < uh_fin[a];
+}
+
+static int uh_other (Node * p) {
+  Clause * c = p->clause;
+  assert (c->size == 2);
+  return c->nodes[c->nodes == p].lit;
+}
+
+static int unhide_dfs (int root, int stamp) {
+  int lit, other;
+  Node * p;
+  assert (!nstack);
+  uh_dsc[root] = ++stamp;
+  uh_next[root] = lit2occ (-root)->first;
+  push_stack (root);
+  while (nstack) {
+    lit = stack[nstack - 1];
+    for (p = uh_next[lit]; p && p->clause->size != 2; p = p->next)
+      ;
+    if (!p) { uh_fin[lit] = ++stamp; nstack--; continue; }
+    uh_next[lit] = p->next;
+    other = uh_other (p);
+    if (uh_dsc[other]) continue;
+    uh_prt[other] = lit;
+    uh_dsc[other] = ++stamp;
+    uh_next[other] = lit2occ (-other)->first;
+    push_stack (other);
+  }
+  return stamp;
+}
+
+static int cmp_uh_dsc (const void * p, const void * q) {
+  return uh_dsc[*(const int *) p] - uh_dsc[*(const int *) q];
+}
+
+static int unhide_tautology (Clause * c) {
+  int i, j, np, nn, lit, * pos, * neg;
+  Node * p;
+  assert (!naux);
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (uh_dsc[lit]) push_aux (lit);
+  np = naux;
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (uh_dsc[-lit]) push_aux (-lit);
+  nn = naux - np;
+  pos = aux, neg = aux + np;
+  qsort (pos, np, sizeof *pos, cmp_uh_dsc);
+  qsort (neg, nn, sizeof *neg, cmp_uh_dsc);
+  i = j = 0;
+  while (i < np && j < nn) {
+    if (uh_dsc[neg[j]] > uh_dsc[pos[i]]) i++;
+    else if (uh_fin[neg[j]] < uh_fin[pos[i]]) j++;
+    else break;
+  }
+  naux = 0;
+  return i < np && j < nn;
+}
+
+/* Pushes the literals of 'c' not implied away onto 'lits' and returns
+ * the number of removed literals.  A literal implying another one left
+ * in the clause is removed, first along the tree below the literal and
+ * then along the tree above its negation.
+ */
+static int unhide_literals (Clause * c) {
+  int i, n, lit, res;
+  Node * p;
+  assert (!naux);
+  assert (!num_lits);
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (uh_dsc[lit]) push_aux (lit); else push_literal (lit);
+  qsort (aux, naux, sizeof *aux, cmp_uh_dsc);
+  n = 0;
+  for (i = 0; i + 1 < naux; i++)
+    if (uh_dsc[aux[i + 1]] >= uh_fin[aux[i]]) aux[n++] = aux[i];
+  if (naux) aux[n++] = aux[naux - 1];
+  for (i = 0; i < n; i++) aux[i] = -aux[i];
+  naux = 0;
+  for (i = 0; i < n; i++)
+    if (uh_dsc[aux[i]]) aux[naux++] = aux[i];
+    else push_literal (-aux[i]);
+  n = naux;
+  qsort (aux, n, sizeof *aux, cmp_uh_dsc);
+  naux = 0;			/* stack of open ancestors in 'aux' */
+  for (i = 0; i < n; i++) {
+    lit = aux[i];
+    while (naux && uh_fin[aux[naux - 1]] < uh_dsc[lit]) naux--;
+    if (!naux) push_literal (-lit);
+    assert (naux <= i);
+    aux[naux++] = lit;
+  }
+  naux = 0;
+  res = c->size - num_lits;
+  assert (res >= 0);
+  return res;
+}
+
+static int unhide_transitive (Clause * c) {
+  int a = c->nodes[0].lit, b = c->nodes[1].lit;
+  assert (c->size == 2);
+  if (uh_prt[b] == -a || uh_prt[a] == -b) return 0;
+  return uh_descendant (-a, b) || uh_descendant (-b, a);
+}
+
+static void unhide_round (void) {
+  int i, j, n, idx, lit, tmp, stamp, nroots, first, * roots, * bins;
+  Clause ** clauses, * c;
+  Node * p;
+  NEWN (uh_dsc, 2*num_vars + 1);
+  NEWN (uh_fin, 2*num_vars + 1);
+  NEWN (uh_prt, 2*num_vars + 1);
+  NEWN (uh_next, 2*num_vars + 1);
+  NEWN (bins, 2*num_vars + 1);
+  NEWN (roots, 2*num_vars);
+  uh_dsc += num_vars, uh_fin += num_vars, uh_prt += num_vars;
+  uh_next += num_vars, bins += num_vars;
+  unhide_rounds++;
+  n = 0;
+  for (c = first_clause; c; c = c->next) {
+    n++;
+    if (c->size != 2) continue;
+    bins[c->nodes[0].lit]++;
+    bins[c->nodes[1].lit]++;
+  }
+  nroots = 0;			/* roots without incoming edges first */
+  for (i = 0; i < 2; i++) {
+    first = nroots;
+    for (idx = 1; idx <= num_vars; idx++) {
+      if (!isfree (idx)) continue;
+      for (lit = -idx; lit <= idx; lit += 2*idx)
+	if (bins[-lit] && !bins[lit] == !i) roots[nroots++] = lit;
+    }
+    for (j = nroots - 1; j > first; j--) {
+      uh_seed = 1664525u * uh_seed + 1013904223u;
+      idx = first + (uh_seed >> 8) % (unsigned) (j - first + 1);
+      tmp = roots[j], roots[j] = roots[idx], roots[idx] = tmp;
+    }
+  }
+  stamp = 0;
+  for (i = 0; i < nroots; i++)
+    if (!uh_dsc[roots[i]]) stamp = unhide_dfs (roots[i], stamp);
+  LOG ("unhiding stamped %d literals", stamp / 2);
+  NEWN (clauses, n);
+  i = 0;
+  for (c = first_clause; c; c = c->next) clauses[i++] = c;
+  for (i = 0; !empty_clause && i < n; i++) {
+    c = clauses[i];
+    for (p = c->nodes; (lit = p->lit); p++)
+      if (deref (lit)) break;
+    if (lit) continue;				/* left to 'flush_trail' */
+    if (c->size > 2 && unhide_tautology (c)) {
+      LOGCLAUSE (c, "unhidden tautology");
+      qrat_lit = 0;
+      QRAT_TRACE_RATE_FROM_CLAUSE (c, "unhidden tautology");
+      delete_clause (c);
+      unhidden_tautologies++;
+      continue;
+    }
+    if (c->size == 2 && unhide_transitive (c)) {
+      LOGCLAUSE (c, "transitive binary");
+      qrat_lit = 0;
+      QRAT_TRACE_RATE_FROM_CLAUSE (c, "transitive reduction");
+      delete_clause (c);
+      unhidden_transitive++;
+      continue;
+    }
+    if (!(tmp = unhide_literals (c))) { num_lits = 0; continue; }
+    LOGCLAUSE (c, "removing %d unhidden literals from", tmp);
+    unhidden_literals += tmp;
+    tmp = !lookup_clause ();
+    if (tmp) QRAT_TRACE_RATA_FROM_STACK0 ("unhidden literals");
+    if (!tmp || trivial_clause ()) num_lits = 0;
+    else add_clause ();
+    qrat_lit = 0;
+    QRAT_TRACE_RATE_FROM_CLAUSE (c, "unhidden literals");
+    delete_clause (c);
+  }
+  for (idx = 1; !empty_clause && idx <= num_vars; idx++)
+    for (lit = -idx; lit <= idx; lit += 2*idx) {
+      if (!uh_dsc[lit] || !uh_descendant (lit, -lit)) continue;
+      if (deref (lit) < 0) continue;
+      LOG ("failed literal %d", lit);
+      unhidden_units++;
+      assert (!num_lits);
+      push_literal (-lit);
+      if (lookup_clause ()) { num_lits = 0; continue; }
+      QRAT_TRACE_RATA_FROM_STACK0 ("failed literal");
+      if (trivial_clause ()) num_lits = 0;
+      else add_clause ();
+      if (empty_clause) break;
+    }
+  DELN (clauses, n);
+  uh_dsc -= num_vars, uh_fin -= num_vars, uh_prt -= num_vars;
+  uh_next -= num_vars, bins -= num_vars;
+  DELN (roots, 2*num_vars);
+  DELN (bins, 2*num_vars + 1);
+  DELN (uh_next, 2*num_vars + 1);
+  DELN (uh_prt, 2*num_vars + 1);
+  DELN (uh_fin, 2*num_vars + 1);
+  DELN (uh_dsc, 2*num_vars + 1);
+}
+
+static void unhiding (void) {
+  double start;
+  int round;
+  if (!unhide || partial_assignment || empty_clause) return;
+  if (!trail_flushed ()) return;
+  start = seconds ();
+  for (round = 0; !empty_clause && round < unhide; round++) {
+    unhide_round ();
+    flush_trail ();
+  }
+  unhideTime += seconds () - start;
+  if (verbose)
+    msg ("unhiding removed %d tautologies and %d transitive clauses",
+         unhidden_tautologies, unhidden_transitive);
+}
+
+/******** failed literal probing ***********/
+
+/* Probing assigns a free existential literal and propagates it with
+ * universal reduction, on watches kept apart from the occurrence lists.
+ * Only existential literals are watched, since universal literals are
+ * never assigned.  A clause propagates its last unassigned existential
+ * 'e' if all its universal literals are inner to 'e', and it is in
+ * conflict if all its existential literals are false.  If propagating
+ * 'lit' fails, the clause '(-lit | U)' with 'U' the universal literals of
+ * the reasons and the conflicting clause is an asymmetric tautology.  If
+ * 'U' has no clashing literals and is inner to 'lit' it reduces to the
+ * unit '-lit'.  For a literal 'l' implied by both 'lit' and '-lit' the
+ * binary clauses '(-lit | l)' and '(lit | l)' are obtained the same way,
+ * if 'U' is inner to both literals, and the unit 'l' is then an
+ * asymmetric tautology.  Scopes are probed from the outermost one inward
+ * until the step limit is reached.
+ */
+
+typedef struct ProbeWatches {
+  int count, size;
+  int * clauses;		/* indices into 'pr_clauses' */
+} ProbeWatches;
+
+static ProbeWatches * pr_watches;
+static Clause ** pr_clauses;
+static int * pr_watched, pr_nclauses;
+static signed char * pr_vals, * pr_implied;
+static int * pr_trail, pr_ntrail, pr_propagated, * pr_lifts, pr_nlifts;
+static int pr_qbf, pr_ignore = -1;	/* universal reduction, skipped clause */
+static int * pr_stamps, pr_stamp, pr_clash;
+static int * pr_univs, pr_nunivs, pr_szunivs;
+static int64_t pr_ticks;
+
+static int probe_val (int lit) {	/* fixed universals are ignored */
+  int res = pr_vals[lit];
+  if (!res && existential (lit) && (res = deref (lit)))
+    res = (res > 0) ? 1 : -1;
+  return res;
+}
+
+static void probe_watch (int lit, int idx) {
+  ProbeWatches * ws = pr_watches + lit;
+  if (ws->count == ws->size) {
+    int new_size = ws->size ? 2 * ws->size : 4;
+    RSZ (ws->clauses, ws->size, new_size);
+    ws->size = new_size;
+  }
+  ws->clauses[ws->count++] = idx;
+}
+
+static void probe_init (int qbf) {
+  int i, n, lit, watched;
+  Clause * c;
+  Node * p;
+  NEWN (pr_watches, 2*num_vars + 1);
+  NEWN (pr_vals, 2*num_vars + 1);
+  NEWN (pr_implied, 2*num_vars + 1);
+  pr_watches += num_vars, pr_vals += num_vars, pr_implied += num_vars;
+  NEWN (pr_stamps, 2*num_vars + 1);
+  pr_stamps += num_vars;
+  NEWN (pr_trail, num_vars);
+  NEWN (pr_lifts, num_vars);
+  n = 0;
+  for (c = first_clause; c; c = c->next) n++;
+  NEWN (pr_clauses, n + 1);
+  NEWN (pr_watched, 2*n + 1);
+  pr_nclauses = 0;
+  pr_qbf = qbf;
+  for (c = first_clause; c; c = c->next) {
+    i = pr_nclauses++;
+    pr_clauses[i] = c;
+    watched = 0;
+    for (p = c->nodes; watched < 2 && (lit = p->lit); p++) {
+      if (qbf && !existential (lit)) continue;
+      pr_watched[2*i + watched++] = lit;
+      probe_watch (lit, i);
+    }
+  }
+}
+
+static void probe_reset (void) {
+  int lit;
+  for (lit = -num_vars; lit <= num_vars; lit++)
+    if (pr_watches[lit].size)
+      DELN (pr_watches[lit].clauses, pr_watches[lit].size);
+  pr_watches -= num_vars, pr_vals -= num_vars, pr_implied -= num_vars;
+  DELN (pr_watches, 2*num_vars + 1);
+  DELN (pr_vals, 2*num_vars + 1);
+  DELN (pr_implied, 2*num_vars + 1);
+  pr_stamps -= num_vars;
+  DELN (pr_stamps, 2*num_vars + 1);
+  DELN (pr_trail, num_vars);
+  DELN (pr_lifts, num_vars);
+  DELN (pr_clauses, pr_nclauses + 1);
+  DELN (pr_watched, 2*pr_nclauses + 1);
+  if (pr_szunivs) DELN (pr_univs, pr_szunivs);
+  pr_univs = 0, pr_nunivs = pr_szunivs = 0;
+}
+
+static void probe_push_univ (int lit) {
+  if (pr_nunivs == pr_szunivs) {
+    int new_size = pr_szunivs ? 2 * pr_szunivs : 16;
+    RSZ (pr_univs, pr_szunivs, new_size);
+    pr_szunivs = new_size;
+  }
+  pr_univs[pr_nunivs++] = lit;
+}
+
+static void probe_univs (Clause * c) {	/* universals of reason/conflict */
+  int lit;
+  Node * p;
+  for (p = c->nodes; (lit = p->lit); p++) {
+    if (existential (lit) || pr_stamps[lit] == pr_stamp) continue;
+    if (pr_stamps[-lit] == pr_stamp) pr_clash = 1;
+    pr_stamps[lit] = pr_stamp;
+    probe_push_univ (lit);
+  }
+}
+
+static void probe_assign (int lit) {
+  assert (!probe_val (lit));
+  assert (!pr_qbf || existential (lit));
+  pr_vals[lit] = 1;
+  pr_vals[-lit] = -1;
+  pr_trail[pr_ntrail++] = lit;
+}
+
+static void probe_backtrack (void) {
+  int i, lit;
+  for (i = 0; i < pr_ntrail; i++) {
+    lit = pr_trail[i];
+    pr_vals[lit] = pr_vals[-lit] = 0;
+  }
+  pr_ntrail = pr_propagated = 0;
+}
+
+static int probe_propagate (void) {	/* returns 0 on conflict */
+  int i, j, idx, lit, other, tmp, min, replacement, * w;
+  ProbeWatches * ws;
+  Clause * c;
+  Node * p;
+  while (pr_propagated < pr_ntrail) {
+    lit = -pr_trail[pr_propagated++];
+    ws = pr_watches + lit;
+    for (i = j = 0; i < ws->count; i++) {
+      idx = ws->clauses[i];
+      if (!(c = pr_clauses[idx])) continue;		/* deleted */
+      if (idx == pr_ignore) { ws->clauses[j++] = idx; continue; }
+      w = pr_watched + 2*idx;
+      other = (w[0] == lit) ? w[1] : w[0];
+      pr_ticks++;
+      if (other && probe_val (other) > 0) { ws->clauses[j++] = idx; continue; }
+      min = INT_MAX;
+      replacement = 0;
+      for (p = c->nodes; (tmp = p->lit); p++) {
+	if (pr_qbf && universal (tmp)) {
+	  if (lit2order (tmp) < min) min = lit2order (tmp);
+	  continue;
+	}
+	if (tmp == lit || tmp == other || probe_val (tmp) < 0) continue;
+	replacement = tmp;
+	break;
+      }
+      if (replacement) {
+	if (w[0] == lit) w[0] = replacement; else w[1] = replacement;
+	probe_watch (replacement, idx);
+	continue;
+      }
+      ws->clauses[j++] = idx;
+      if (other && !probe_val (other)) {
+	if (min < lit2order (other)) continue;	/* blocked by universal */
+	if (pr_qbf) probe_univs (c);
+	probe_assign (other);
+      } else {
+	LOGCLAUSE (c, "probing conflict on");
+	if (pr_qbf) probe_univs (c);
+	while (++i < ws->count) ws->clauses[j++] = ws->clauses[i];
+	ws->count = j;
+	return 0;
+      }
+    }
+    ws->count = j;
+  }
+  return 1;
+}
+
+static int probe_lit (int lit) {	/* returns 1 if 'lit' failed */
+  assert (!pr_ntrail);
+  pr_stamp++;
+  pr_clash = 0;
+  probed_lits++;
+  probe_assign (lit);
+  return !probe_propagate ();
+}
+
+static int probe_reducible (int from, int to, int order) {
+  int i;
+  for (i = from; i < to; i++)
+    if (lit2order (pr_univs[i]) < order) return 0;
+  return 1;
+}
+
+/* Adds '(a | b | U)' which 'add_clause' reduces to '(a | b)'.
+ */
+static void probe_add (int a, int b, int from, int to) {
+  assert (!num_lits);
+  if (deref (a) || (b && deref (b))) return;
+  push_literal (a);
+  if (b) push_literal (b);
+  while (from < to) push_literal (pr_univs[from++]);
+  qrat_lit = 0;
+  QRAT_TRACE_RATA_FROM_STACK0 ("probing");
+  if (trivial_clause ()) num_lits = 0;
+  else add_clause ();
+}
+
+static void probe_var (int idx) {
+  int i, n, lit, tmp, order, first, second, clash;
+  order = lit2order (idx);
+  pr_nunivs = 0;
+  first = probe_lit (idx);
+  clash = pr_clash;
+  pr_nlifts = 0;
+  if (!first)
+    for (i = 1; i < pr_ntrail; i++) {
+      lit = pr_trail[i];
+      pr_implied[lit] = 1;
+      pr_lifts[pr_nlifts++] = lit;
+    }
+  probe_backtrack ();
+  if (first) {
+    if (clash || !probe_reducible (0, pr_nunivs, order)) return;
+    LOG ("failed literal %d in probing", idx);
+    failed_lits++;
+    probe_add (-idx, 0, 0, pr_nunivs);
+    return;
+  }
+  n = pr_nunivs;
+  second = probe_lit (-idx);
+  if (!second)
+    for (i = 1; i < pr_ntrail; i++)
+      if (pr_implied[lit = pr_trail[i]]) pr_implied[lit] = 2;
+  probe_backtrack ();
+  if (second) {
+    if (!pr_clash && probe_reducible (n, pr_nunivs, order)) {
+      LOG ("failed literal %d in probing", -idx);
+      failed_lits++;
+      probe_add (idx, 0, n, pr_nunivs);
+    }
+  } else if (!clash && !pr_clash)
+    for (i = 0; !empty_clause && i < pr_nlifts; i++) {
+      lit = pr_lifts[i];
+      if (pr_implied[lit] < 2) continue;
+      if (deref (lit)) continue;
+      tmp = lit2order (lit);
+      if (tmp < order) tmp = order;
+      if (!probe_reducible (0, pr_nunivs, tmp)) continue;
+      LOG ("lifted literal %d from probing %d", lit, idx);
+      lifted_lits++;
+      probe_add (-idx, lit, 0, n);
+      probe_add (idx, lit, n, pr_nunivs);
+      probe_add (lit, 0, 0, 0);
+    }
+  for (i = 0; i < pr_nlifts; i++) pr_implied[pr_lifts[i]] = 0;
+}
+
+static void probing (void) {
+  double start;
+  Scope * s;
+  Var * v;
+  int idx;
+  if (!probe || partial_assignment || empty_clause) return;
+  if (!trail_flushed ()) return;
+  start = seconds ();
+  probe_rounds++;
+  probe_init (1);
+  pr_ticks = 0;
+  for (s = outer_most_scope; !empty_clause && s; s = s->inner) {
+    if (s->type < 0) continue;
+    for (v = s->first; !empty_clause && v; v = v->next) {
+      if (pr_ticks > probesteps) break;
+      idx = v - vars;
+      if (!isfree (idx) || deref (idx)) continue;
+      if (!lit2occ (idx)->count || !lit2occ (-idx)->count) continue;
+      probe_var (idx);
+    }
+  }
+  probe_reset ();
+  flush_trail ();
+  probeTime += seconds () - start;
+  if (verbose)
+    msg ("probing found %d failed and %d lifted literals",
+         failed_lits, lifted_lits);
+}
+
+/******** vivification ***********/
+
+/* Vivification reuses the probing watches without universal reduction,
+ * since removing literals implied by the matrix keeps it equivalent.  The
+ * negations of the literals of a candidate clause are assigned from the
+ * outermost to the innermost scope and propagated over the other clauses.
+ * A literal found false is dropped, while a literal found true or a
+ * conflict ends the clause with the literals assigned so far.  The result
+ * is an asymmetric tautology, added before the original clause is
+ * deleted.  If no literal was removed the clause itself is redundant and
+ * just deleted.  Long clauses are vivified first.
+ */
+
+static int cmp_vivify_lits (const void * p, const void * q) {
+  int a = *(const int *) p, b = *(const int *) q, res;
+  if ((res = lit2order (a) - lit2order (b))) return res;
+  return abs (a) - abs (b);
+}
+
+static int cmp_vivify_clauses (const void * p, const void * q) {
+  int a = *(const int *) p, b = *(const int *) q, res;
+  if ((res = pr_clauses[b]->size - pr_clauses[a]->size)) return res;
+  return a - b;
+}
+
+static void vivify_clause (int idx) {
+  Clause * c = pr_clauses[idx];
+  int i, lit, val, redundant;
+  Node * p;
+  assert (!naux);
+  assert (!num_lits);
+  for (p = c->nodes; (lit = p->lit); p++) {
+    if (deref (lit)) { naux = 0; return; }	/* left to 'flush_trail' */
+    push_aux (lit);
+  }
+  qsort (aux, naux, sizeof *aux, cmp_vivify_lits);
+  pr_ignore = idx;
+  redundant = 0;
+  for (i = 0; !redundant && i < naux; i++) {
+    lit = aux[i];
+    if ((val = probe_val (lit)) < 0) continue;
+    push_literal (lit);
+    if (val > 0) redundant = 1;
+    else {
+      probe_assign (-lit);
+      redundant = !probe_propagate ();
+    }
+  }
+  naux = 0;
+  probe_backtrack ();
+  pr_ignore = -1;
+  if (!redundant && num_lits == c->size) { num_lits = 0; return; }
+  if (num_lits < c->size) {
+    LOGCLAUSE (c, "removing %d vivified literals from", c->size - num_lits);
+    vivified_lits += c->size - num_lits;
+    vivified_clauses++;
+    i = !lookup_clause ();
+    if (i) QRAT_TRACE_RATA_FROM_STACK0 ("vivification");
+    if (!i || trivial_clause ()) num_lits = 0;
+    else add_clause ();
+  } else {
+    LOGCLAUSE (c, "vivification redundant");
+    vivified_redundant++;
+    num_lits = 0;
+  }
+  qrat_lit = 0;
+  QRAT_TRACE_RATE_FROM_CLAUSE (c, "vivification");
+  delete_clause (c);
+  pr_clauses[idx] = 0;
+}
+
+static void vivify (void) {
+  int i, n, * schedule;
+  double start;
+  if (!vivification || partial_assignment || empty_clause) return;
+  if (!trail_flushed ()) return;
+  start = seconds ();
+  vivify_rounds++;
+  probe_init (0);
+  pr_ticks = 0;
+  NEWN (schedule, pr_nclauses + 1);
+  n = 0;
+  for (i = 0; i < pr_nclauses; i++)
+    if (pr_clauses[i]->size > 2) schedule[n++] = i;
+  qsort (schedule, n, sizeof *schedule, cmp_vivify_clauses);
+  for (i = 0; !empty_clause && i < n && pr_ticks <= vivifysteps; i++)
+    vivify_clause (schedule[i]);
+  DELN (schedule, pr_nclauses + 1);
+  probe_reset ();
+  flush_trail ();
+  vivifyTime += seconds () - start;
+  if (verbose)
+    msg ("vivification removed %d literals and %d clauses",
+         vivified_lits, vivified_redundant);
+}
+
+/******** asymmetric tautology elimination ***********/
+
+/* A clause is an asymmetric tautology if assigning its negation and
+ * propagating over the remaining clauses on the probing watches gives a
+ * conflict.  Such a clause is implied and deleted.  Otherwise it has the
+ * QRAT property on an existential literal 'l' if every outer resolvent on
+ * 'l' is an asymmetric tautology.  The outer resolvent with a clause 'D'
+ * containing '-l' only adds the literals of 'D' which are not inner to
+ * 'l', which generalizes the resolvent used in 'block_clause'.  The
+ * negation of the clause is kept assigned while checking the resolvents.
+ * Long clauses are checked first until the step limit is reached.
+ */
+
+static void ate_backtrack (int level) {
+  int lit;
+  while (pr_ntrail > level) {
+    lit = pr_trail[--pr_ntrail];
+    pr_vals[lit] = pr_vals[-lit] = 0;
+  }
+  pr_propagated = level;
+}
+
+static int ate_assign (int lit) {	/* returns 0 on conflict */
+  int val = probe_val (lit);
+  if (val > 0) return 0;
+  if (val < 0) return 1;
+  probe_assign (-lit);
+  return probe_propagate ();
+}
+
+static int ate_resolvent (Clause * d, int pivot) {
+  int order, lit, res;
+  Node * p;
+  order = lit2order (pivot);
+  res = 0;
+  for (p = d->nodes; !res && (lit = p->lit); p++) {
+    if (lit == -pivot || lit2order (lit) > order) continue;
+    res = !ate_assign (lit);
+  }
+  return res;
+}
+
+static int ate_qrat (Clause * c, int pivot) {
+  int level, res;
+  Node * p;
+  level = pr_ntrail;
+  res = 1;
+  for (p = lit2occ (-pivot)->first; res && p; p = p->next) {
+    if (p->clause == c) continue;
+    if (pr_ticks > atesteps) res = 0;
+    else res = ate_resolvent (p->clause, pivot);
+    ate_backtrack (level);
+  }
+  return res;
+}
+
+static void ate_clause (int idx) {
+  Clause * c = pr_clauses[idx];
+  int lit, pivot, conflict;
+  Node * p;
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (deref (lit)) return;			/* left to 'flush_trail' */
+  pr_ignore = idx;
+  conflict = 0;
+  for (p = c->nodes; !conflict && (lit = p->lit); p++)
+    conflict = !ate_assign (lit);
+  pivot = 0;
+  if (!conflict)
+    for (p = c->nodes; !pivot && (lit = p->lit); p++)
+      if (existential (lit) && ate_qrat (c, lit)) pivot = lit;
+  probe_backtrack ();
+  pr_ignore = -1;
+  if (!conflict && !pivot) return;
+  if (conflict) {
+    LOGCLAUSE (c, "asymmetric tautology");
+    ate_clauses++;
+  } else {
+    LOGCLAUSE (c, "qrat clause on %d", pivot);
+    qrate_clauses++;
+  }
+  qrat_lit = pivot;
+  QRAT_TRACE_RATE_FROM_CLAUSE (c, conflict ? "ate" : "qrate");
+  delete_clause (c);
+  pr_clauses[idx] = 0;
+}
+
+static void ate (void) {
+  int i, n, * schedule;
+  double start;
+  if (!asymmetric || partial_assignment || empty_clause) return;
+  if (!trail_flushed ()) return;
+  start = seconds ();
+  ate_rounds++;
+  probe_init (0);
+  pr_ticks = 0;
+  NEWN (schedule, pr_nclauses + 1);
+  n = 0;
+  for (i = 0; i < pr_nclauses; i++)
+    if (pr_clauses[i]->size > 1) schedule[n++] = i;
+  qsort (schedule, n, sizeof *schedule, cmp_vivify_clauses);
+  for (i = 0; !empty_clause && i < n && pr_ticks <= atesteps; i++)
+    ate_clause (schedule[i]);
+  DELN (schedule, pr_nclauses + 1);
+  probe_reset ();
+  flush_trail ();
+  ateTime += seconds () - start;
+  if (verbose)
+    msg ("eliminated %d asymmetric tautologies and %d qrat clauses",
+         ate_clauses, qrate_clauses);
+}
+
+/******** bounded variable addition ***********/
+
+/* Bounded variable addition replaces the clauses (l_i | C_j) for all
+ * literals l_i in 'L' and remainders C_j in 'M' by (l_i | -x) and (C_j | x)
+ * over a fresh variable 'x', which saves |L|*|M| - |L| - |M| clauses.
+ * Eliminating 'x' gives back the original clauses, which is only sound if
+ * 'x' is an existential of the innermost scope.  We further only match
+ * clauses reaching into this scope, such that the order of no clause
+ * changes.  The literal sets 'L' are grown greedily from the most
+ * frequent literals as in 'SimpleBVA' of Manthey, Heule and Biere.  This
+ * runs after preprocessing, since elimination would just undo it.
+ */
+
+static int * bva_lits, nbva_lits, szbva_lits;
+static int * bva_pairs, nbva_pairs, szbva_pairs;
+static int * bva_count, bva_max_idx;
+static int64_t bva_ticks;
+
+static void push_bva_lit (int lit) {
+  int new_size;
+  if (szbva_lits == nbva_lits) {
+    new_size = szbva_lits ? 2*szbva_lits : 1;
+    RSZ (bva_lits, szbva_lits, new_size);
+    szbva_lits = new_size;
+  }
+  bva_lits[nbva_lits++] = lit;
+}
+
+static void push_bva_pair (int lit, int pos) {
+  int new_size;
+  if (szbva_pairs <= nbva_pairs + 1) {
+    new_size = szbva_pairs ? 2*szbva_pairs : 2;
+    RSZ (bva_pairs, szbva_pairs, new_size);
+    szbva_pairs = new_size;
+  }
+  bva_pairs[nbva_pairs++] = lit;
+  bva_pairs[nbva_pairs++] = pos;
+}
+
+static int bva_candidate (Clause * c) {
+  return c->size > 1 && c->maxorder == inner_most_scope->order;
+}
+
+static int bva_reduction (int nlits, int nclauses) {
+  return nlits * nclauses - nlits - nclauses;
+}
+
+static int bva_matched (int lit) {
+  int i;
+  for (i = 0; i < nbva_lits; i++)
+    if (bva_lits[i] == lit) return 1;
+  return 0;
+}
+
+/* Collects in 'bva_pairs' all literals 'other' and positions 'i' such that
+ * the clause 'clauses[i]' with 'lit' replaced by 'other' exists and returns
+ * the most frequent such literal.
+ */
+static int bva_match (int lit, Clause ** clauses, int nclauses) {
+  int i, other, min, unmarked, res;
+  Clause * c, * d;
+  Node * p, * n;
+  nbva_pairs = 0;
+  for (i = 0; i < nclauses; i++) {
+    c = clauses[i];
+    min = 0;
+    for (p = c->nodes; (other = p->lit); p++) {
+      if (other == lit) continue;
+      mark_lit (other);
+      if (!min || lit2occ (other)->count < lit2occ (min)->count) min = other;
+    }
+    for (n = lit2occ (min)->first; n; n = n->next) {
+      d = n->clause;
+      bva_ticks++;
+      if (d == c || d->size != c->size || !bva_candidate (d)) continue;
+      unmarked = 0;
+      for (p = d->nodes; (other = p->lit); p++) {
+        if (lit2var (other)->mark == other) continue;
+        if (unmarked) { unmarked = 0; break; }
+        unmarked = other;
+      }
+      if (!unmarked || unmarked == lit) continue;
+      if (abs (unmarked) > bva_max_idx || bva_matched (unmarked)) continue;
+      bva_count[unmarked]++;
+      push_bva_pair (unmarked, i);
+    }
+    for (p = c->nodes; (other = p->lit); p++)
+      if (other != lit) unmark_lit (other);
+  }
+  res = 0;
+  for (i = 0; i < nbva_pairs; i += 2) {
+    other = bva_pairs[i];
+    if (!res || bva_count[other] > bva_count[res] ||
+        (bva_count[other] == bva_count[res] && abs (other) < abs (res)))
+      res = other;
+  }
+  return res;
+}
+
+static void bva_replace (int lit, Clause ** clauses, int nclauses) {
+  int i, j, x, other;
+  Clause * c, * d;
+  Node * p;
+  assert (trail_flushed ());
+  x = num_vars + 1;
+  enlarge_vars (x);
+  add_quantifier (x);
+  LOG ("bva variable %d replaces %d clauses by %d",
+       x, nbva_lits * nclauses, nbva_lits + nclauses);
+  bva_vars++;
+  bva_added += nbva_lits + nclauses;
+  bva_removed += nbva_lits * nclauses;
+  for (i = 0; i < nbva_lits; i++) {
+    assert (!num_lits);
+    push_literal (bva_lits[i]);
+    push_literal (-x);
+    qrat_lit = -x;
+    QRAT_TRACE_RATA_FROM_STACK0 ("bva");
+    if (trivial_clause ()) num_lits = 0; else add_clause ();
+  }
+  for (i = 0; i < nclauses; i++) {
+    assert (!num_lits);
+    for (p = clauses[i]->nodes; (other = p->lit); p++)
+      if (other != lit) push_literal (other);
+    push_literal (x);
+    qrat_lit = x;
+    QRAT_TRACE_RATA_FROM_STACK0 ("bva");
+    if (trivial_clause ()) num_lits = 0; else add_clause ();
+  }
+  for (i = 0; i < nclauses; i++) {
+    c = clauses[i];
+    for (j = 1; j < nbva_lits; j++) {
+      assert (!num_lits);
+      for (p = c->nodes; (other = p->lit); p++)
+        if (other != lit) push_literal (other);
+      push_literal (bva_lits[j]);
+      d = lookup_clause ();
+      num_lits = 0;
+      assert (d && d != c);
+      qrat_lit = 0;
+      QRAT_TRACE_RATE_FROM_CLAUSE (d, "bva");
+      delete_clause (d);
+    }
+    qrat_lit = 0;
+    QRAT_TRACE_RATE_FROM_CLAUSE (c, "bva");
+    delete_clause (c);
+  }
+}
+
+static int bva_lit (int lit) {
+  int i, k, nclauses, other, count;
+  Clause ** clauses;
+  Node * n;
+  if (deref (lit)) return 0;
+  count = lit2occ (lit)->count;
+  if (count < 2) return 0;
+  NEWN (clauses, count);
+  nclauses = 0;
+  for (n = lit2occ (lit)->first; n; n = n->next)
+    if (bva_candidate (n->clause)) clauses[nclauses++] = n->clause;
+  nbva_lits = 0;
+  push_bva_lit (lit);
+  while (nclauses > 1 && bva_ticks <= bvasteps) {
+    other = bva_match (lit, clauses, nclauses);
+    for (i = 0; i < nbva_pairs; i += 2) bva_count[bva_pairs[i]] = 0;
+    if (!other) break;
+    k = 0;
+    for (i = 0; i < nbva_pairs; i += 2)
+      if (bva_pairs[i] == other) k++;
+    if (bva_reduction (nbva_lits + 1, k) <=
+        bva_reduction (nbva_lits, nclauses)) break;
+    k = 0;
+    for (i = 0; i < nbva_pairs; i += 2)
+      if (bva_pairs[i] == other) clauses[k++] = clauses[bva_pairs[i + 1]];
+    push_bva_lit (other);
+    nclauses = k;
+  }
+  k = bva_reduction (nbva_lits, nclauses) > 0;
+  if (k) bva_replace (lit, clauses, nclauses);
+  DELN (clauses, count);
+  return k;
+}
+
+static int cmp_bva_lits (const void * p, const void * q) {
+  int a = *(const int *) p, b = *(const int *) q, res;
+  if ((res = lit2occ (b)->count - lit2occ (a)->count)) return res;
+  return a - b;
+}
+
+static void variable_addition (void) {
+  int idx, lit, i, n, * todo;
+  double start;
+  if (!bva || partial_assignment || empty_clause) return;
+  if (!inner_most_scope || inner_most_scope->type < 0) return;
+  if (!trail_flushed ()) return;
+  start = seconds ();
+  bva_max_idx = num_vars;
+  bva_ticks = 0;
+  NEWN (bva_count, 2*bva_max_idx + 1);
+  bva_count += bva_max_idx;
+  NEWN (todo, 2*bva_max_idx);
+  n = 0;
+  for (idx = 1; idx <= bva_max_idx; idx++) {
+    if (vars[idx].tag != FREE) continue;
+    for (lit = -idx; lit <= idx; lit += 2*idx)
+      if (lit2occ (lit)->count > 2) todo[n++] = lit;
+  }
+  qsort (todo, n, sizeof *todo, cmp_bva_lits);
+  for (i = 0; !empty_clause && i < n && bva_ticks <= bvasteps; i++)
+    while (bva_lit (todo[i])) {
+      flush_trail ();
+      if (empty_clause) break;
+    }
+  DELN (todo, 2*bva_max_idx);
+  bva_count -= bva_max_idx;
+  DELN (bva_count, 2*bva_max_idx + 1);
+  DELN (bva_lits, szbva_lits);
+  szbva_lits = nbva_lits = 0;
+  DELN (bva_pairs, szbva_pairs);
+  szbva_pairs = nbva_pairs = 0;
+  flush (0);
+  bvaTime += seconds () - start;
+  msg ("added %d variables replacing %d by %d clauses",
+       bva_vars, bva_removed, bva_added);
+}
+
+static int pop_literal (void) {
+  assert (num_lits > 0);
+  return lits[--num_lits];
+}
+
+static void dfs_clean (void) {
+  memset (dfsi - num_vars, 0, (2*num_vars + 1) * sizeof *dfsi);
+  memset (mindfsi - num_vars, 0, (2*num_vars + 1) * sizeof *mindfsi);
+  memset (repr - num_vars, 0, (2*num_vars + 1) * sizeof *repr);
+}
+
+static int cmporder (int a, int b) {
+  int res;
+  if ((res = lit2order (a) - lit2order (b))) return res;
+  if ((res = abs (a) - abs (b))) return res;
+  return b - a;
+}
+
+static int subst_clause (Clause * c) {
+  int lit, tmp, res;
+  Node * p;
+  assert (!num_lits);
+  res = 0;
+
+  LOGCLAUSE(c, "trying subst clause");
+  for (p = c->nodes; (lit = p->lit); p++) {
+    tmp = repr[lit];
+    if (partial_assignment && vars[abs(tmp)].scope->order == assigned_scope) 
+      tmp = lit;
+    assert (tmp);
+    if (tmp != lit) {
+      res = 1;
+    }
+    push_literal (tmp);
+  }
+  if (!res) { num_lits = 0; return 0; }
 
   if (!lookup_clause ()) {
     qrat_lit = 0;
@@ -3795,7 +5691,7 @@ static Clause * lookup_clause_without (int from, int to) {
   for (n=o->first;n; n=n->next) {
    c = n->clause;
    LOGCLAUSE(c,"checking clause");
-   if (sig != c->sig) continue;
+   if (sig != c->sig[0]) continue;
    if ((c->size != (slits_size))) continue;
 
    is_clause = 1;
@@ -3839,7 +5735,7 @@ static Clause * lookup_clause () {
   Sig sig = sig_lits2 (slits, slits_size);
   LOG("looking up clause with signature  %016llx", sig);
 
-  DELN(slits, num_lits);
+  if (sortlits) sort_lits (slits, slits_size);
   lit = least_occuring_lit ();
 
   o = lit2occ (lit);
@@ -3849,9 +5745,9 @@ static Clause * lookup_clause () {
   for (n=o->first;n; n=n->next) {
    c = n->clause;
    LOGCLAUSE(c,"looking up ");
-   if (sig != c->sig) {
+   if (sig != c->sig[0]) {
     LOG("%d %d",slits_size, c->size); 
-    LOG("looking up clause with signature  %016llx", c->sig);
+    LOG("looking up clause with signature  %016llx", c->sig[0]);
      continue;
    }
    if ((c->size != slits_size)) {
@@ -3859,7 +5755,10 @@ static Clause * lookup_clause () {
    }
    is_clause = 1;
 
-   for (p=c->nodes;(lit=p->lit);p++) {
+   if (sortlits) {
+     for (p=c->nodes;(lit=p->lit);p++)
+       if (lit != slits[p - c->nodes]) { is_clause = 0; break; }
+   } else for (p=c->nodes;(lit=p->lit);p++) {
      v = lit2var (lit);
      if ((v->lmark != lit) && (v->lmark2 != lit)) {
        is_clause = 0;
@@ -3867,11 +5766,13 @@ static Clause * lookup_clause () {
    }
    if (!is_clause) continue;
 
+   DELN(slits, num_lits);
    unmark_stack_lits ();
    LOGCLAUSE(c,"found clause");
    return c;
   }
 
+  DELN(slits, num_lits);
   unmark_stack_lits ();
   return NULL;
 }
@@ -4459,12 +6360,207 @@ static void flush (int outer) {
   flush_queue (outer);
 }
 
+/******** worker threads ***********/
+
+/* Workers share read-only access to the formula during parallel phases.
+ * Each gets a strided share of the items and private scratch marks, since
+ * the 'mark' fields of variables and clauses are global.
+ */
+
+typedef struct Worker {
+  pthread_t thread;
+  int first, step;		/* strided share of the items */
+  int bound;			/* private cost bound */
+  signed char * marks;		/* private literal marks */
+  int * pos, * stack;		/* private traversal stack */
+  int * buf, nbuf, szbuf;	/* private results of all items */
+} Worker;
+
+static Worker * workers;
+static int nworkers, szmarks;
+
+static void init_workers (void) {
+  Worker * w;
+  if (nworkers == threads && szmarks == num_vars + 1) return;
+  for (w = workers; w < workers + nworkers; w++) {
+    DELN (w->marks, szmarks);
+    DELN (w->pos, szmarks);
+    DELN (w->stack, szmarks);
+    free (w->buf);
+  }
+  DELN (workers, nworkers);
+  nworkers = threads;
+  szmarks = num_vars + 1;
+  NEWN (workers, nworkers);
+  for (w = workers; w < workers + nworkers; w++) {
+    NEWN (w->marks, szmarks);
+    NEWN (w->pos, szmarks);
+    NEWN (w->stack, szmarks);
+  }
+}
+
+static void push_worker_buf (Worker * w, int val) {
+  if (w->nbuf == w->szbuf) {
+    w->szbuf = w->szbuf ? 2*w->szbuf : 1024;
+    w->buf = realloc (w->buf, w->szbuf * sizeof *w->buf);
+    if (!w->buf) die ("out of memory");
+  }
+  w->buf[w->nbuf++] = val;
+}
+
+static void run_workers (void * (*fun) (void *), int items) {
+  int i, spawned;
+  Worker * w;
+  init_workers ();
+  spawned = 0;
+  if (items >= 2 * nworkers) {
+    for (i = 0; i < nworkers; i++) {
+      w = workers + i;
+      w->first = i;
+      w->step = nworkers;
+    }
+    for (w = workers + 1; w < workers + nworkers; w++, spawned++)
+      if (pthread_create (&w->thread, 0, fun, w)) break;
+    for (i = 0; i < nworkers - spawned; i++)
+      fun (workers + (i ? spawned + i : 0));
+    for (w = workers + 1; w <= workers + spawned; w++)
+      if (pthread_join (w->thread, 0)) die ("can not join worker thread");
+  } else {
+    workers[0].first = 0;
+    workers[0].step = 1;
+    fun (workers);
+  }
+}
+
+/******** parallel elimination ***********/
+
+/* With '--threads=<n>' the elimination candidates are collected in
+ * batches.  Blocked clauses are removed sequentially, but the number of
+ * resolvents of candidates with disjoint occurrence neighbourhoods is
+ * counted in parallel, using private literal marks.  Afterwards
+ * candidates are committed in schedule order, where only those not
+ * already shown to exceed their limit are checked and resolved away again
+ * sequentially.  Thus the result does not depend on thread scheduling.
+ */
+
+typedef struct Candidate {
+  int idx, limit;
+  int res;			/* 1=eliminate, 0=skip, -1=check sequentially */
+} Candidate;
+
+static Candidate * candidates;
+static int ncandidates, szcandidates;
+static int64_t ve_batches, ve_parallel, ve_pruned, ve_overlapping;
+
+static int count_resolvents (int idx, int limit, signed char * marks) {
+  int order, lit, nontriv, mini_scope, clash, unit, relaxed;
+  Node * p, * q, * r;
+  Clause * c, * d;
+  order = lit2order (idx);
+  relaxed = dep_miniscope (idx);
+  nontriv = unit = 0;
+  for (p = lit2occ (idx)->first; !unit && nontriv <= limit && p; p = p->next) {
+    c = p->clause;
+    if (c->size > elimsize) { nontriv = INT_MAX-1; continue; }
+    for (r = c->nodes; (lit = r->lit); r++) marks[abs (lit)] = sign (lit);
+    mini_scope = 1;
+    for (q = lit2occ (-idx)->first;
+         !unit && nontriv <= limit && q;
+         q = q->next) {
+      d = q->clause;
+      if (d->size > elimsize) { nontriv = INT_MAX-1; continue; }
+      clash = 0;
+      if (!relaxed && d->maxorder > order) mini_scope = 0;
+      for (r = d->nodes; (lit = r->lit); r++) {
+	if (lit == -idx) continue;
+	if (!relaxed && d->maxorder > order && lit2order (lit) > order) {
+	  if (sortlits > 1) break;
+	  continue;
+	}
+	if (marks[abs (lit)] == -sign (lit)) { clash = lit; break; }
+      }
+      if (clash) {
+	if (!mini_scope && strict) nontriv = INT_MAX;
+      } else if (mini_scope) {
+	nontriv++;
+	if (c->size == 2 && d->size == 2 &&
+	    c->nodes[abs (c->nodes[0].lit) == idx].lit ==
+	    d->nodes[abs (d->nodes[0].lit) == idx].lit) unit = 1;
+      } else nontriv = INT_MAX;
+    }
+    for (r = c->nodes; (lit = r->lit); r++) marks[abs (lit)] = 0;
+  }
+  if (unit) return -1;
+  return nontriv <= limit;
+}
+
+static void * count_resolvents_worker (void * arg) {
+  Worker * w = arg;
+  Candidate * e;
+  int i;
+  for (i = w->first; i < ncandidates; i += w->step) {
+    e = candidates + i;
+    if (e->res > 0) e->res = count_resolvents (e->idx, e->limit, w->marks);
+  }
+  return 0;
+}
+
+static void push_candidate (int idx) {
+  int limit = block_idx (idx);
+  flush (0);
+  if (limit < 0 || empty_clause || !isfree (idx)) return;
+  if (ncandidates == szcandidates) {
+    RSZ (candidates, szcandidates, szcandidates ? 2*szcandidates : 16);
+    szcandidates = szcandidates ? 2*szcandidates : 16;
+  }
+  candidates[ncandidates].idx = idx;
+  candidates[ncandidates].limit = limit;
+  candidates[ncandidates].res = find_gate (idx) ? -1 : 1;
+  reset_gate (idx);
+  ncandidates++;
+}
+
+static int overlapping_candidate (int idx) {
+  int sign, res = 0;
+  Node * p;
+  for (sign = -1; sign <= 1; sign += 2)
+    for (p = lit2occ (sign * idx)->first; p; p = p->next) {
+      if (p->clause->mark == expansion_cost_mark) res = 1;
+      p->clause->mark = expansion_cost_mark;
+    }
+  return res;
+}
+
+static void elim_batch (void) {
+  Candidate * e;
+  int limit;
+  if (empty_clause) ncandidates = 0;
+  if (!ncandidates) return;
+  ve_batches++;
+  expansion_cost_mark++;
+  assert (expansion_cost_mark > 0);
+  for (e = candidates; e < candidates + ncandidates; e++)
+    if (overlapping_candidate (e->idx)) e->res = -1, ve_overlapping++;
+    else ve_parallel++;
+  run_workers (count_resolvents_worker, ncandidates);
+  for (e = candidates; !empty_clause && e < candidates + ncandidates; e++) {
+    if (!e->res) { ve_pruned++; continue; }
+    if (!isfree (e->idx)) continue;
+    if (null_occurrences (e->idx)) { zombie (e->idx); continue; }
+    limit = e->res < 0 ? elim_limit (e->idx) : e->limit;
+    if (limit >= 0) resolve_idx (e->idx, limit);
+    flush (0);
+  }
+  ncandidates = 0;
+}
+
 static void elim (void) {
   double start = seconds ();
   int idx;
   assert (!empty_clause);
   assert (trail_flushed ());
   assert (!queue);
+  std_deps ();
   start_progress ("elimination queue", &size_schedule);
   do {
     while (!empty_clause && size_schedule) {
@@ -4482,12 +6578,19 @@ static void elim (void) {
         }
         continue;
       }
+      if (threads > 1) {
+        push_candidate (idx);
+        if (ncandidates >= 8 * threads) elim_batch ();
+        continue;
+      }
       elim_idx (idx);
       flush (0);
     }
+    elim_batch ();
     if (!empty_clause && eqres (0)) flush (0);
   } while (!empty_clause && size_schedule);
   stop_progress ();
+  depvalid = 0;
   msg ("elimination took %.1f seconds", seconds () - start);
   elimTime += (seconds () - start);
 }
@@ -4572,26 +6675,193 @@ static int expand_cost_trav (int pivot, int bound) {
 	  mark_lit (other);
 	}
       }
-    }
+    }
+  }
+  assert (nstack > 0);
+  LOG ("scope of universal %d has %d existential variables and %d clauses",
+       pivot, nstack-1, res + occs);
+  LOG ("expansion cost of %d would be at most %d clauses", pivot, res);
+  return res;
+}
+
+/* With '--depscheme=2' existentials in the expansion cone of 'pivot' are
+ * only copied if they depend on it in the resolution-path dependency
+ * scheme, i.e. if there are resolution paths through existentials of the
+ * cone from 'pivot' to 'e' and from '-pivot' to '-e', or from 'pivot' to
+ * '-e' and from '-pivot' to 'e'.  The other existentials have strategies
+ * independent of 'pivot' and are shared by both copies.  The cone of
+ * 'expand_cost_trav' is the one of the standard dependency scheme and thus
+ * remains an upper bound on the expansion cost.
+ */
+static void rp_reach (int start, signed char * reached, int bit) {
+  int i, lit, other;
+  Node * p, * q;
+  assert (!naux);
+  push_aux (start);
+  for (i = 0; i < naux; i++) {
+    lit = aux[i];
+    for (p = lit2occ (lit)->first; p; p = p->next)
+      for (q = p->clause->nodes; (other = q->lit); q++) {
+	reached[other] |= bit;
+	if (other == lit || abs (other) == abs (start)) continue;
+	if (!lit2var (other)->mark) continue;		/* not in cone */
+	if (reached[-other] & (bit << 2)) continue;
+	reached[-other] |= bit << 2;
+	push_aux (-other);
+      }
+  }
+  naux = 0;
+}
+
+static void rp_filter_cone (int pivot) {
+  int i, n, idx, sign;
+  signed char * reached;
+  Node * p;
+  assert (nstack && stack[0] == pivot);
+  NEWN (reached, 2*num_vars + 1);
+  reached += num_vars;
+  rp_reach (pivot, reached, 1);
+  rp_reach (-pivot, reached, 2);
+  for (n = i = 1; i < nstack; i++) {
+    idx = stack[i];
+    if (((reached[idx] & 1) && (reached[-idx] & 2)) ||
+        ((reached[-idx] & 1) && (reached[idx] & 2))) stack[n++] = idx;
+    else {
+      LOG ("resolution paths do not make %d depend on %d", idx, pivot);
+      unmark_lit (idx);
+      dep_uncopied++;
+    }
+  }
+  nstack = n;
+  reached -= num_vars;
+  DELN (reached, 2*num_vars + 1);
+  expansion_cost_mark++;
+  for (i = 0; i < nstack; i++)
+    for (sign = -1; sign <= 1; sign += 2)
+      for (p = lit2occ (sign * stack[i])->first; p; p = p->next)
+	p->clause->mark = expansion_cost_mark;
+}
+
+static void expand_cost_clear (void) {
+  while (nstack > 0) unmark_lit (stack[--nstack]);
+  check_all_unmarked ();
+}
+
+
+/* Same as 'expand_cost' but only reads the formula.  Instead of marking
+ * clauses, a clause is counted when reached from the first of its
+ * variables on the private traversal stack.
+ */
+static int expand_cost_private (int pivot, int bound, Worker * w, int * nptr) {
+  int next, n, lit, other, res, sign, stretch;
+  Node * p, * q;
+  Clause * c;
+  n = 0;
+  w->stack[n++] = pivot;
+  *nptr = n;
+  if (!univ_mini && !in_innermost_ublock (pivot)) return INT_MAX;
+  res = -(lit2occ (pivot)->count + lit2occ (-pivot)->count);
+  stretch = lit2stretch (pivot);
+  w->pos[pivot] = n;
+  for (next = 0; res < INT_MAX && next < n; next++) {
+    lit = w->stack[next];
+    for (sign = 1; res < INT_MAX && sign >= -1; sign -= 2)
+      for (p = lit2occ (sign * lit)->first; res < INT_MAX && p; p = p->next) {
+	c = p->clause;
+	for (q = c->nodes; (other = abs (q->lit)); q++)
+	  if (w->pos[other] && w->pos[other] <= next) break;
+	if (other) continue;
+	if (++res > bound) { res = INT_MAX; break; }
+	for (q = c->nodes; (other = abs (q->lit)); q++) {
+	  if (w->pos[other]) continue;
+	  if (lit2stretch (other) <= stretch) continue;
+	  if (universal (other)) { res = INT_MAX; break; }
+	  w->stack[n++] = other;
+	  w->pos[other] = n;
+	}
+      }
   }
-  assert (nstack > 0);
-  LOG ("scope of universal %d has %d existential variables and %d clauses",
-       pivot, nstack-1, res + occs);
-  LOG ("expansion cost of %d would be at most %d clauses", pivot, res);
+  *nptr = n;
   return res;
 }
 
-static void expand_cost_clear (void) {
-  while (nstack > 0) unmark_lit (stack[--nstack]);
-  check_all_unmarked ();
+/* Expansion costs are cached per universal together with the variables
+ * traversed to compute them.  The entry stays valid as long as none of
+ * these variables had an occurrence added or removed after the epoch it
+ * was computed in, and scope stretches did not change.  A cost exceeding
+ * the bound is only reused for bounds not larger than the cached one.
+ * Universals outside of the innermost universal block with '--no-exp-mini'
+ * are rejected before and never cached, since that block may change.
+ */
+
+static int cached_expand_cost (int pivot, int bound, int * res) {
+  Var * v = vars + pivot;
+  int i;
+  exp_cache_lookups++;
+  if (!v->expstamp || v->expstamp < exp_valid_epoch) return 0;
+  if (v->expcost == INT_MAX && bound > v->expbound) return 0;
+  for (i = 0; i < v->ncone; i++)
+    if (vars[v->cone[i]].touched > v->expstamp) return 0;
+  exp_cache_hits++;
+  *res = (v->expcost <= bound) ? v->expcost : INT_MAX;
+  return 1;
+}
+
+static void cache_expand_cost (int pivot, int bound, int cost,
+                               int * cone, int ncone) {
+  Var * v = vars + pivot;
+  if (v->ncone != ncone) {
+    DELN (v->cone, v->ncone);
+    NEWN (v->cone, ncone);
+    v->ncone = ncone;
+  }
+  memcpy (v->cone, cone, ncone * sizeof *cone);
+  v->expstamp = exp_epoch;
+  v->expcost = cost;
+  v->expbound = bound;
 }
 
 static int expand_cost (int pivot, int bound) {
-  int res = expand_cost_trav (pivot, bound);
+  int res;
+  if (!univ_mini && !in_innermost_ublock (pivot)) return INT_MAX;
+  if (cached_expand_cost (pivot, bound, &res)) return res;
+  res = expand_cost_trav (pivot, bound);
+  cache_expand_cost (pivot, bound, res, stack, nstack);
   expand_cost_clear ();
   return res;
 }
 
+typedef struct ExpCandidate {
+  int lit, cost, bound, cached;
+  int cone, ncone;		/* traversed variables in 'worker->buf' */
+  Worker * worker;
+} ExpCandidate;
+
+static ExpCandidate * exp_candidates;
+static int nexp_candidates, szexp_candidates;
+
+static void * expand_cost_worker (void * arg) {
+  ExpCandidate * e;
+  Worker * w = arg;
+  int i, j, n;
+  w->nbuf = 0;
+  for (i = w->first; i < nexp_candidates; i += w->step) {
+    e = exp_candidates + i;
+    if (e->cached) continue;
+    e->bound = w->bound;
+    e->cost = expand_cost_private (e->lit, e->bound, w, &n);
+    if (e->cost < w->bound) w->bound = e->cost;
+    e->worker = w;
+    e->cone = w->nbuf;
+    e->ncone = n;
+    for (j = 0; j < n; j++) {
+      push_worker_buf (w, w->stack[j]);
+      w->pos[w->stack[j]] = 0;
+    }
+  }
+  return 0;
+}
+
 static void stretch_scopes (void) {
   Scope * p, * q, * next;
   for (p = outer_most_scope; p; p = p->inner) {
@@ -4600,6 +6870,7 @@ static void stretch_scopes (void) {
            (!next->free || next->type == p->type))
       q = next;
     while (p != q) {
+      if (p->stretch != q->order) stretched = 1;
       p->stretch = q->order;
       if (p->free)
 	LOG ("scope %d actually stretches until scope %d",
@@ -4741,6 +7012,112 @@ static void expand_clause (Clause * c, int pivot) {
 
 }
 
+/* With '--threads=<n>' the renamed copies of an expansion are built in
+ * parallel into private buffers of the workers.  Copies forward subsumed
+ * by clauses present before the expansion are detected there as well,
+ * with private literal marks.  None of these clauses contains the pivot,
+ * so they survive the expansion.  The other copies are added in the
+ * original clause order through 'add_clause', which still takes care of
+ * strengthening, units and subsumption among the copies.
+ */
+
+typedef struct ExpCopy {
+  Clause * source;
+  int start, size;		/* copy in 'worker->buf', size<0 if dropped */
+  int subsumed;
+  Worker * worker;
+} ExpCopy;
+
+static ExpCopy * exp_copies;
+static int nexp_copies, szexp_copies, exp_pivot;
+static int64_t exp_parallel_copies;
+
+static int forward_subsumed_private (int * clause, int size,
+                                     signed char * marks) {
+  int i, lit, other, res;
+  Anchor * anchor;
+  Clause * c;
+  Node * p;
+  Sig sig[SIGWORDS];
+  memset (sig, 0, sizeof sig);
+  for (i = 0; i < size; i++) {
+    lit = clause[i];
+    marks[abs (lit)] = sign (lit);
+    lit2wsig (lit, sig);
+  }
+  res = 0;
+  for (i = 0; !res && i < size; i++) {
+    lit = clause[i];
+    if (!(fwsigs [ abs (lit) ] & sig[0])) continue;
+    anchor = anchors + abs (lit);
+    if (anchor->count > fwmaxoccs) continue;
+    for (c = anchor->first; !res && c; c = c->watch.next) {
+      if (c->size > size || wsig_excluded (c->sig, sig)) continue;
+      for (p = c->nodes; (other = p->lit); p++)
+	if (marks[abs (other)] != sign (other)) break;
+      res = !other;
+    }
+  }
+  for (i = 0; i < size; i++) marks[abs (clause[i])] = 0;
+  return res;
+}
+
+static void * expand_copy_worker (void * arg) {
+  Worker * w = arg;
+  ExpCopy * e;
+  int i, lit;
+  Node * p;
+  w->nbuf = 0;
+  for (i = w->first; i < nexp_copies; i += w->step) {
+    e = exp_copies + i;
+    e->worker = w;
+    e->start = w->nbuf;
+    for (p = e->source->nodes; (lit = p->lit); p++) {
+      if (lit == exp_pivot) continue;
+      if (lit == -exp_pivot) break;
+      push_worker_buf (w, expand_lit (lit));
+    }
+    if (lit) { w->nbuf = e->start; e->size = -1; continue; }
+    e->size = w->nbuf - e->start;
+    e->subsumed = forward_subsumed_private (w->buf + e->start, e->size,
+                                            w->marks);
+  }
+  return 0;
+}
+
+static void expand_clauses_parallel (int pivot, Clause * last) {
+  ExpCopy * e;
+  Clause * c;
+  int i;
+  nexp_copies = 0;
+  for (c = first_clause; c; c = c->next) {
+    if (c->mark == expansion_cost_mark) {
+      if (nexp_copies == szexp_copies) {
+	i = szexp_copies ? 2*szexp_copies : 1024;
+	RSZ (exp_copies, szexp_copies, i);
+	szexp_copies = i;
+      }
+      exp_copies[nexp_copies++].source = c;
+    }
+    if (c == last) break;
+  }
+  exp_pivot = pivot;
+  run_workers (expand_copy_worker, nexp_copies);
+  exp_parallel_copies += nexp_copies;
+  for (e = exp_copies; !empty_clause && e < exp_copies + nexp_copies; e++) {
+    if (e->size < 0) continue;
+    if (e->subsumed) {
+      forward_subsumed_clauses++;
+      subsumed_clauses++;
+      continue;
+    }
+    assert (!num_lits);
+    for (i = 0; i < e->size; i++) push_literal (e->worker->buf[e->start + i]);
+    if (trivial_clause ()) num_lits = 0;
+    else add_clause ();
+  }
+}
+
 static void expand (int pivot, int expected) {
   int ncopied, i, idx, first_new_var;
   #ifndef NDEBUG
@@ -4765,6 +7142,7 @@ static void expand (int pivot, int expected) {
   assert (max_cost == expected);
   LOG ("max cost for expansion %d", max_cost);
   #endif
+  if (depscheme > 1 && !qrat_file) rp_filter_cone (pivot);
 
   for (ncopied = 0; ncopied + 1 < nstack; ncopied++) {
     idx = stack[ncopied + 1];
@@ -4775,7 +7153,7 @@ static void expand (int pivot, int expected) {
   }
   expand_cost_clear ();
   first_new_var = num_vars + 1;
-  enlarge_vars (num_vars + ncopied);
+  if (ncopied) enlarge_vars (num_vars + ncopied);
   assert (inner_most_scope->type > 0);
   for (i = 0; i < ncopied; i++) {
     idx = stack[i + 1];
@@ -4801,7 +7179,8 @@ static void expand (int pivot, int expected) {
   assert (first_clause);
   last = last_clause;
   c = first_clause;
-  do { 
+  if (threads > 1 && !qrat_file) expand_clauses_parallel (pivot, last);
+  else do { 
     if (c->mark == expansion_cost_mark) 
       expand_clause (c, pivot);
     if (c == last) break;
@@ -4900,47 +7279,267 @@ static void expand (int pivot, int expected) {
     if (null_occurrences (idx)) zombie (idx);
 }
 
+static size_t expansion_bytes (int cost) {
+  int64_t literals;
+  Clause * c;
+  if (!num_clauses) return 0;
+  literals = 0;
+  for (c = first_clause; c; c = c->next) literals += c->size;
+  return cost * bytes_clause (literals / num_clauses + 1);
+}
+
+/* With '--explook=<n>' the 'n' cheapest expansion candidates are ranked by
+ * their net effect instead of the number of copied clauses.  The cone of
+ * each of them is traversed again to estimate the clauses removed right
+ * after the expansion.  Binary clauses with the pivot become units in one
+ * of the copies and satisfy the clauses of the other literal.  Variables
+ * of the cone losing all occurrences of one phase in a copy become pure.
+ * Finally clauses of the cone shortened by removing the pivot may subsume
+ * other copied clauses, which is checked on occurrence lists not longer
+ * than '--fwmaxoccs'.
+ */
+
+typedef struct ExpLook { int lit, cost; } ExpLook;
+
+static ExpLook * exp_looks;
+static int nexp_looks, szexp_looks;
+
+static void push_exp_look (int lit, int cost) {
+  int new_size;
+  if (nexp_looks == szexp_looks) {
+    new_size = szexp_looks ? 2*szexp_looks : 16;
+    RSZ (exp_looks, szexp_looks, new_size);
+    szexp_looks = new_size;
+  }
+  exp_looks[nexp_looks].lit = lit;
+  exp_looks[nexp_looks++].cost = cost;
+}
+
+static int cmp_exp_looks (const void * p, const void * q) {
+  const ExpLook * a = p, * b = q;
+  if (a->cost != b->cost) return (a->cost < b->cost) ? -1 : 1;
+  return a->lit - b->lit;
+}
+
+static int contains_lit (Clause * c, int lit) {
+  Node * p;
+  for (p = c->nodes; p->lit; p++)
+    if (p->lit == lit) return 1;
+  return 0;
+}
+
+static int expand_look_pure (int idx, int pivot) {
+  int res, sign, copy, count[2];
+  Node * p;
+  res = 0;
+  for (copy = -1; copy <= 1; copy += 2) {
+    for (sign = 0; sign <= 1; sign++) {
+      count[sign] = 0;
+      for (p = vars[idx].occs[sign].first; p; p = p->next)
+	if (!contains_lit (p->clause, copy * pivot)) count[sign]++;
+    }
+    if (!count[0] || !count[1]) res += count[0] + count[1];
+  }
+  return res;
+}
+
+static int expand_look_subsumed (Clause * c, int pivot) {
+  int lit, min, res, count;
+  Node * p, * q;
+  Clause * d;
+  res = min = 0;
+  for (p = c->nodes; (lit = p->lit); p++) {
+    if (abs (lit) == pivot) continue;
+    submark_lit (lit);
+    if (!min || lit2occ (lit)->count < lit2occ (min)->count) min = lit;
+  }
+  if (min && lit2occ (min)->count <= fwmaxoccs)
+    for (p = lit2occ (min)->first; p; p = p->next) {
+      d = p->clause;
+      if (d->size < c->size - 1) continue;
+      if (d->mark != expansion_cost_mark) continue;
+      count = 0;
+      for (q = d->nodes; (lit = q->lit); q++) {
+	if (abs (lit) == pivot) break;
+	if (lit2var (lit)->submark == lit) count++;
+      }
+      if (!lit && count == c->size - 1) res++;
+    }
+  for (p = c->nodes; (lit = p->lit); p++)
+    if (abs (lit) != pivot) unsubmark_lit (lit);
+  return res;
+}
+
+static int expand_look (int pivot, int cost) {
+  int i, sign, lit, other, gain;
+  Clause * c;
+  Node * p;
+  if (expand_cost_trav (pivot, cost + 1) != cost) {
+    expand_cost_clear ();
+    return cost;
+  }
+  gain = 0;
+  for (i = 1; i < nstack; i++) gain += expand_look_pure (stack[i], pivot);
+  for (sign = -1; sign <= 1; sign += 2) {
+    lit = sign * pivot;
+    for (p = lit2occ (lit)->first; p; p = p->next) {
+      c = p->clause;
+      if (c->size == 2) {
+	other = c->nodes[0].lit;
+	if (other == lit) other = c->nodes[1].lit;
+	if (existential (other)) gain += lit2occ (other)->count;
+      } else gain += expand_look_subsumed (c, pivot);
+    }
+  }
+  expand_cost_clear ();
+  LOG ("expansion of %d with cost %d is estimated to remove %d clauses",
+       pivot, cost, gain);
+  return cost - gain;
+}
+
+static int expand_look_best (int * cost) {
+  int i, n, score, min, res;
+  qsort (exp_looks, nexp_looks, sizeof *exp_looks, cmp_exp_looks);
+  n = (nexp_looks < explook) ? nexp_looks : explook;
+  res = 0;
+  min = INT_MAX;
+  for (i = 0; i < n; i++) {
+    score = expand_look (exp_looks[i].lit, exp_looks[i].cost);
+    if (res && score >= min) continue;
+    res = exp_looks[i].lit;
+    *cost = exp_looks[i].cost;
+    min = score;
+  }
+  nexp_looks = 0;
+  return res;
+}
+
+/* With '--expblock=<k>' up to 'k' universals of the scope of the first
+ * expanded universal are expanded in one call, as long as their summed
+ * expansion costs stay within '--axcess'.  This saves the rounds of the
+ * main loop in between, which on 2QBF formulas otherwise each run the
+ * full simplification for every single expanded universal.
+ */
+static int next_block_expansion (Scope * s, int bound, int * cost) {
+  int lit, min, best, tmp;
+  Var * v;
+  stretched = 0;
+  stretch_scopes ();
+  if (stretched) exp_valid_epoch = exp_epoch;
+  best = 0;
+  min = bound + 1;
+  for (v = s->first; min > 0 && v; v = v->next) {
+    if (partial_assignment && v->scope->order == assigned_scope) continue;
+    if (v->tag != FREE) continue;
+    lit = v - vars;
+    tmp = expand_cost (lit, min);
+    if (tmp == INT_MAX || tmp >= min) continue;
+    best = lit;
+    min = tmp;
+  }
+  exp_epoch++;
+  *cost = min;
+  return best;
+}
+
 static int try_expand (void) {
-  int cost, lit, best, min, lim;
+  int cost, lit, best, min, lim, i, sum;
   int delta;
   double start, time;
-  Scope * p;
+  ExpCandidate * e;
+  Scope * p, * scope;
   Var * v;
 
   if (!exp) return 0;
 
   start = seconds ();
+  stretched = 0;
   stretch_scopes ();
-  min = lim = (axcess < INT_MAX) ? (axcess + 1) : INT_MAX;
+  if (stretched) exp_valid_epoch = exp_epoch;
+  if (expsolve) min = lim = INT_MAX;
+  else min = lim = (axcess < INT_MAX) ? (axcess + 1) : INT_MAX;
   best = 0;
+  nexp_candidates = 0;
+  cost = min;
   for (p = inner_most_scope; p; p = p->outer) {
     if (p->type > 0) continue;
     for (v = p->first; v; v = v->next) {
       if (partial_assignment && v->scope->order == assigned_scope) continue;
       if (v->tag != FREE) continue;
       lit = v - vars;
-      cost = expand_cost (lit, min);
+      if (!univ_mini && !in_innermost_ublock (lit)) continue;
+      if (threads > 1) {
+        if (nexp_candidates == szexp_candidates) {
+          i = szexp_candidates ? 2*szexp_candidates : 16;
+          RSZ (exp_candidates, szexp_candidates, i);
+          szexp_candidates = i;
+        }
+        e = exp_candidates + nexp_candidates++;
+        e->lit = lit;
+        e->worker = 0;
+        e->cached = cached_expand_cost (lit, lim, &e->cost);
+        if (e->cached && e->cost < cost) cost = e->cost;
+        continue;
+      }
+      cost = expand_cost (lit, explook ? lim : min);
       if (cost == INT_MAX) continue;
+      if (explook && cost < lim) push_exp_look (lit, cost);
       if (cost >= min) continue;
       best = lit;
       min = cost;
     }
   }
+  if (nexp_candidates) {
+    init_workers ();
+    for (i = 0; i < nworkers; i++) workers[i].bound = cost;
+    run_workers (expand_cost_worker, nexp_candidates);
+    for (e = exp_candidates; e < exp_candidates + nexp_candidates; e++) {
+      if (e->worker)
+        cache_expand_cost (e->lit, e->bound, e->cost,
+                           e->worker->buf + e->cone, e->ncone);
+      if (explook && e->cost < lim) push_exp_look (e->lit, e->cost);
+      if (e->cost >= min) continue;
+      best = e->lit;
+      min = e->cost;
+    }
+  }
+  if (nexp_looks > 1) best = expand_look_best (&min);
+  nexp_looks = 0;
+  exp_epoch++;
   assert (min == lim || best);
   LOG ("minimial expansion cost is at most %d expanding %d", min, best);
   time = seconds () - start;
   expTime += time;
-  if (min > axcess) {
+  if (!best || (!expsolve && min > axcess)) {
     msg ("minimial expansion cost limit of %d exceeded in %.1f seconds",
          axcess, time);
     return 0;
   }
+  if (expsolve && current_bytes + expansion_bytes (min) > 
+                  ((size_t) expmem << 20)) {
+    msg ("expansion of %d clauses would exceed memory limit of %d MB",
+         min, expmem);
+    return 0;
+  }
   msg ("found minimial expansion cost of %d in %.1f seconds", min, time);
   delta = num_clauses;
   expand (best, min);
   flush (0);
+  scope = lit2scope (best);
+  sum = min;
+  for (i = 1; i < expblock && !empty_clause && num_clauses; i++) {
+    lim = expsolve ? INT_MAX - 1 : axcess - sum;
+    if (lim < 0 || !(best = next_block_expansion (scope, lim, &min))) break;
+    if (expsolve && current_bytes + expansion_bytes (min) > 
+                    ((size_t) expmem << 20)) break;
+    LOG ("jointly expanding %d with cost %d", best, min);
+    block_expanded++;
+    expand (best, min);
+    flush (0);
+    if (sum < INT_MAX - min) sum += min;
+  }
   delta -= num_clauses;
-  LOG ("expansion of %d removed %d clauses", best, delta);
+  LOG ("expansion removed %d clauses", delta);
   expTime += (seconds() - start);
   return 1;
 }
@@ -5103,83 +7702,731 @@ static void split (void) {
   assert (num_vars + 1 == next_idx);
   flush (0);
 
-  splitTime += (seconds() - start);
+  splitTime += (seconds() - start);
+}
+
+static void map_vars (void) {
+  Var * v;
+  mapped = 0;
+  assert (trail_flushed ());
+  for (v = vars + 1; v <= vars + num_vars; v++) {
+    if (v->tag != FREE) continue;
+    v->mapped = ++mapped;
+    LOG ("mapped %d to %d", (int)(long)(v - vars), mapped);
+  }
+  if (empty_clause) assert (!mapped), remaining = 0;
+  else assert (mapped == remaining);
+}
+
+static void print_clause (Clause * c, FILE * file) {
+  Node * p;
+  for (p = c->nodes; p->lit; p++)
+    fprintf (file, "%d ", map_lit (p->lit));
+  fputs ("0\n", file);
+}
+
+static void print_clauses (FILE * file) {
+  Clause * p;
+  for (p = first_clause; p; p = p->next)
+    print_clause (p, file);
+}
+
+static int print_scope (Scope * s, FILE * file, int pscope) {
+  Var * p;
+
+  if (!pscope || (pscope != s->type)) {
+    if (pscope) fputs (" 0\n", file);
+    fputc (s->type < 0 ? 'a' : 'e', file);
+  }
+  for (p = s->first; p; p = p->next) {
+    if (p->tag != FREE) continue;
+    fprintf (file, " %d", map_lit (var2lit (p)));
+  }
+  return s->type;
+}
+
+static int empty_scope (Scope * s) {
+  int res = 1;
+  Var * p;
+  for (p = s->first; res && p; p = p->next)
+    if (p->tag == FREE)
+      res = 0;
+  assert (res == !s->free);
+  return res;
+}
+
+static int propositional (void) {
+  Scope * p;
+  for (p = outer_most_scope; p; p = p->inner)
+    if (p->type < 0 && !empty_scope (p)) return 0;
+  return 1;
+}
+
+static void print_scopes (FILE * file) {
+  int type = 0; 
+  Scope * p, * first = 0;
+  if (propositional () && !quantifyall) return;
+  for (p = outer_most_scope; p; p = p->inner) {
+    if (!quantifyall && !first && p->type > 0) continue;
+    if (empty_scope (p)) { continue; }
+    first = p;
+    type = print_scope (p, file, type);
+  }
+  if (type) fputs (" 0\n", file);
+}
+
+static void print (FILE * file) {
+  fprintf (file, "p cnf %d %d\n", mapped, num_clauses);
+  print_scopes (file);
+  print_clauses (file);
+}
+
+/******** embedded SAT solver ***********/
+
+/* A small one-shot CDCL solver with watched literals, VSIDS scores,
+ * phase saving, Luby restarts and glue based learned clause reduction.
+ * Clauses are added with 'sat_add' after 'sat_init' and solved once.
+ * If 'sat_proof' is set, learned clauses are traced in QRAT format, which
+ * yields a refutation of the added clauses in the unsatisfiable case.
+ */
+
+typedef struct SatClause {
+  int size, glue;
+  int learned, garbage;
+  int lits[2];			/* embedded literals, actually 'size' many */
+} SatClause;
+
+typedef struct SatWatch {
+  int blit;			/* blocking literal */
+  SatClause * clause;
+} SatWatch;
+
+typedef struct SatWatches {
+  int count, size;
+  SatWatch * watches;
+} SatWatches;
+
+static int sat_max_var, sat_level, sat_inconsistent;
+static signed char * sat_vals, * sat_phases, * sat_seen;
+static int * sat_levels, * sat_heap, * sat_heap_pos, * sat_stamps;
+static SatClause ** sat_reasons;
+static double * sat_scores, sat_score_inc;
+static SatWatches * sat_watches;
+static int * sat_trail, sat_ntrail, sat_propagated;
+static int * sat_control, sat_nheap;
+static int * sat_clause, sat_nclause, sat_szclause;
+static int * sat_units, sat_nunits, sat_szunits;
+static SatClause ** sat_clauses, ** sat_learned;
+static int sat_nclauses, sat_szclauses, sat_nlearned, sat_szlearned;
+static FILE * sat_proof;
+static double sat_deadline;	/* checked at restarts if non-zero */
+
+static int64_t sat_conflicts, sat_decisions, sat_propagations;
+static int64_t sat_restarts, sat_reductions;
+static double satTime = 0, relaxTime = 0;
+
+static int sat_ulit (int lit) { return 2 * abs (lit) + (lit < 0); }
+
+static int sat_val (int lit) { return sat_vals[sat_ulit (lit)]; }
+
+static void sat_init (int max_var) {
+  int i;
+  assert (!sat_max_var);
+  sat_max_var = max_var;
+  NEWN (sat_vals, 2 * (max_var + 1));
+  NEWN (sat_watches, 2 * (max_var + 1));
+  NEWN (sat_phases, max_var + 1);
+  NEWN (sat_seen, max_var + 1);
+  NEWN (sat_levels, max_var + 1);
+  NEWN (sat_reasons, max_var + 1);
+  NEWN (sat_scores, max_var + 1);
+  NEWN (sat_heap, max_var + 1);
+  NEWN (sat_heap_pos, max_var + 1);
+  NEWN (sat_stamps, max_var + 1);
+  NEWN (sat_trail, max_var + 1);
+  NEWN (sat_control, max_var + 1);
+  for (i = 0; i <= max_var; i++) sat_heap_pos[i] = -1;
+  sat_score_inc = 1;
+  sat_level = sat_inconsistent = 0;
+  sat_ntrail = sat_propagated = sat_nheap = 0;
+}
+
+static size_t sat_bytes_clause (int size) {
+  return sizeof (SatClause) + (size - 2) * sizeof (int);
+}
+
+static void sat_delete_clause (SatClause * c) {
+  size_t bytes = sat_bytes_clause (c->size);
+  DEC (bytes);
+  free (c);
+}
+
+static void sat_release (void) {
+  int i, n = sat_max_var;
+  for (i = 0; i < sat_nclauses; i++) sat_delete_clause (sat_clauses[i]);
+  for (i = 0; i < sat_nlearned; i++) sat_delete_clause (sat_learned[i]);
+  DELN (sat_clauses, sat_szclauses);
+  DELN (sat_learned, sat_szlearned);
+  sat_nclauses = sat_szclauses = sat_nlearned = sat_szlearned = 0;
+  sat_clauses = sat_learned = 0;
+  for (i = 0; i < 2 * (n + 1); i++)
+    DELN (sat_watches[i].watches, sat_watches[i].size);
+  DELN (sat_watches, 2 * (n + 1));
+  DELN (sat_vals, 2 * (n + 1));
+  DELN (sat_phases, n + 1);
+  DELN (sat_seen, n + 1);
+  DELN (sat_levels, n + 1);
+  DELN (sat_reasons, n + 1);
+  DELN (sat_scores, n + 1);
+  DELN (sat_heap, n + 1);
+  DELN (sat_heap_pos, n + 1);
+  DELN (sat_stamps, n + 1);
+  DELN (sat_trail, n + 1);
+  DELN (sat_control, n + 1);
+  DELN (sat_clause, sat_szclause);
+  sat_clause = 0;
+  sat_nclause = sat_szclause = 0;
+  DELN (sat_units, sat_szunits);
+  sat_units = 0;
+  sat_nunits = sat_szunits = 0;
+  sat_max_var = 0;
+}
+
+static void sat_push_clause_lit (int lit) {
+  if (sat_nclause == sat_szclause) {
+    int new_size = sat_szclause ? 2 * sat_szclause : 16;
+    RSZ (sat_clause, sat_szclause, new_size);
+    sat_szclause = new_size;
+  }
+  sat_clause[sat_nclause++] = lit;
+}
+
+static void sat_watch (int lit, int blit, SatClause * c) {
+  SatWatches * ws = sat_watches + sat_ulit (lit);
+  if (ws->count == ws->size) {
+    int new_size = ws->size ? 2 * ws->size : 4;
+    RSZ (ws->watches, ws->size, new_size);
+    ws->size = new_size;
+  }
+  ws->watches[ws->count].blit = blit;
+  ws->watches[ws->count].clause = c;
+  ws->count++;
+}
+
+static SatClause * sat_new_clause (int learned, int glue) {
+  size_t bytes = sat_bytes_clause (sat_nclause);
+  SatClause * res;
+  assert (sat_nclause >= 2);
+  res = malloc (bytes);
+  if (!res) die ("out of memory");
+  INC (bytes);
+  res->size = sat_nclause;
+  res->glue = glue;
+  res->learned = learned;
+  res->garbage = 0;
+  memcpy (res->lits, sat_clause, sat_nclause * sizeof (int));
+  sat_watch (res->lits[0], res->lits[1], res);
+  sat_watch (res->lits[1], res->lits[0], res);
+  if (learned) {
+    if (sat_nlearned == sat_szlearned) {
+      int new_size = sat_szlearned ? 2 * sat_szlearned : 64;
+      RSZ (sat_learned, sat_szlearned, new_size);
+      sat_szlearned = new_size;
+    }
+    sat_learned[sat_nlearned++] = res;
+  } else {
+    if (sat_nclauses == sat_szclauses) {
+      int new_size = sat_szclauses ? 2 * sat_szclauses : 64;
+      RSZ (sat_clauses, sat_szclauses, new_size);
+      sat_szclauses = new_size;
+    }
+    sat_clauses[sat_nclauses++] = res;
+  }
+  return res;
+}
+
+static void sat_add (int lit) {
+  assert (sat_max_var);
+  assert (abs (lit) <= sat_max_var);
+  if (lit) { sat_push_clause_lit (lit); return; }
+  if (!sat_nclause) sat_inconsistent = 1;
+  else if (sat_nclause == 1) {
+    if (sat_nunits == sat_szunits) {
+      int new_size = sat_szunits ? 2 * sat_szunits : 16;
+      RSZ (sat_units, sat_szunits, new_size);
+      sat_szunits = new_size;
+    }
+    sat_units[sat_nunits++] = sat_clause[0];
+  } else sat_new_clause (0, 0);
+  sat_nclause = 0;
+}
+
+static int sat_heap_less (int a, int b) {
+  return sat_scores[a] < sat_scores[b];
+}
+
+static void sat_heap_up (int idx) {
+  int pos = sat_heap_pos[idx], parent, tmp;
+  while (pos > 0) {
+    parent = (pos - 1) / 2;
+    tmp = sat_heap[parent];
+    if (!sat_heap_less (tmp, idx)) break;
+    sat_heap[pos] = tmp;
+    sat_heap_pos[tmp] = pos;
+    pos = parent;
+  }
+  sat_heap[pos] = idx;
+  sat_heap_pos[idx] = pos;
+}
+
+static void sat_heap_down (int idx) {
+  int pos = sat_heap_pos[idx], child, tmp;
+  for (;;) {
+    child = 2 * pos + 1;
+    if (child >= sat_nheap) break;
+    if (child + 1 < sat_nheap &&
+        sat_heap_less (sat_heap[child], sat_heap[child + 1])) child++;
+    tmp = sat_heap[child];
+    if (!sat_heap_less (idx, tmp)) break;
+    sat_heap[pos] = tmp;
+    sat_heap_pos[tmp] = pos;
+    pos = child;
+  }
+  sat_heap[pos] = idx;
+  sat_heap_pos[idx] = pos;
+}
+
+static void sat_heap_push (int idx) {
+  if (sat_heap_pos[idx] >= 0) return;
+  sat_heap_pos[idx] = sat_nheap;
+  sat_heap[sat_nheap++] = idx;
+  sat_heap_up (idx);
+}
+
+static int sat_heap_pop (void) {
+  int res = sat_heap[0], last = sat_heap[--sat_nheap];
+  sat_heap_pos[res] = -1;
+  if (sat_nheap) {
+    sat_heap_pos[last] = 0;
+    sat_heap_down (last);
+  }
+  return res;
+}
+
+static void sat_bump (int idx) {
+  int i;
+  if ((sat_scores[idx] += sat_score_inc) > 1e100) {
+    for (i = 1; i <= sat_max_var; i++) sat_scores[i] *= 1e-100;
+    sat_score_inc *= 1e-100;
+  }
+  if (sat_heap_pos[idx] >= 0) sat_heap_up (idx);
+}
+
+static void sat_assign (int lit, SatClause * reason) {
+  int idx = abs (lit);
+  assert (!sat_val (lit));
+  sat_vals[sat_ulit (lit)] = 1;
+  sat_vals[sat_ulit (-lit)] = -1;
+  sat_levels[idx] = sat_level;
+  sat_reasons[idx] = reason;
+  sat_trail[sat_ntrail++] = lit;
+}
+
+static void sat_backtrack (int level) {
+  int lit, idx;
+  assert (level < sat_level);
+  while (sat_ntrail > sat_control[level]) {
+    lit = sat_trail[--sat_ntrail];
+    idx = abs (lit);
+    sat_vals[sat_ulit (lit)] = sat_vals[sat_ulit (-lit)] = 0;
+    sat_phases[idx] = lit < 0 ? -1 : 1;
+    sat_reasons[idx] = 0;
+    sat_heap_push (idx);
+  }
+  sat_propagated = sat_ntrail;
+  sat_level = level;
+}
+
+static SatClause * sat_propagate (void) {
+  SatWatch * p, * q, * end;
+  int lit, other, i, tmp;
+  SatClause * c, * res;
+  SatWatches * ws;
+  res = 0;
+  while (!res && sat_propagated < sat_ntrail) {
+    lit = -sat_trail[sat_propagated++];
+    sat_propagations++;
+    ws = sat_watches + sat_ulit (lit);
+    end = ws->watches + ws->count;
+    for (p = q = ws->watches; p < end; p++) {
+      *q++ = *p;
+      if (res || sat_val (p->blit) > 0) continue;
+      c = p->clause;
+      if (c->lits[0] == lit) c->lits[0] = c->lits[1], c->lits[1] = lit;
+      assert (c->lits[1] == lit);
+      other = c->lits[0];
+      if (sat_val (other) > 0) { q[-1].blit = other; continue; }
+      for (i = 2; i < c->size; i++)
+        if (sat_val (c->lits[i]) >= 0) break;
+      if (i < c->size) {
+        tmp = c->lits[i];
+        c->lits[1] = tmp;
+        c->lits[i] = lit;
+        sat_watch (tmp, other, c);
+        q--;
+      } else if (sat_val (other) < 0) res = c;
+      else sat_assign (other, c);
+    }
+    ws->count = q - ws->watches;
+  }
+  return res;
+}
+
+static void sat_trace_clause (void) {
+  int i;
+  if (!sat_proof) return;
+  for (i = 0; i < sat_nclause; i++) fprintf (sat_proof, "%d ", sat_clause[i]);
+  fputs ("0\n", sat_proof);
+}
+
+static int sat_redundant (int lit) {
+  SatClause * reason = sat_reasons[abs (lit)];
+  int i, other;
+  if (!reason) return 0;
+  for (i = 1; i < reason->size; i++) {
+    other = reason->lits[i];
+    if (!sat_levels[abs (other)]) continue;
+    if (!sat_seen[abs (other)]) return 0;
+  }
+  return 1;
+}
+
+static int sat_analyze (SatClause * conflict) {
+  int i, j, lit, idx, open, level, glue, pos;
+  SatClause * reason;
+  sat_nclause = 0;
+  sat_push_clause_lit (0);
+  reason = conflict;
+  lit = 0;
+  open = 0;
+  pos = sat_ntrail;
+  for (;;) {
+    for (i = (lit != 0); i < reason->size; i++) {
+      int other = reason->lits[i];
+      idx = abs (other);
+      if (sat_seen[idx] || !sat_levels[idx]) continue;
+      sat_seen[idx] = 1;
+      sat_bump (idx);
+      if (sat_levels[idx] == sat_level) open++;
+      else sat_push_clause_lit (other);
+    }
+    do lit = sat_trail[--pos]; while (!sat_seen[abs (lit)]);
+    if (!--open) break;
+    reason = sat_reasons[abs (lit)];
+    assert (reason && reason->lits[0] == lit);
+  }
+  sat_clause[0] = -lit;
+  sat_seen[abs (lit)] = 1;
+  for (i = j = 1; i < sat_nclause; i++) {
+    lit = sat_clause[i];
+    if (sat_redundant (lit)) continue;
+    sat_clause[i] = sat_clause[j];
+    sat_clause[j++] = lit;
+  }
+  for (i = 0; i < sat_nclause; i++) sat_seen[abs (sat_clause[i])] = 0;
+  for (i = sat_ntrail - 1; i >= pos; i--) sat_seen[abs (sat_trail[i])] = 0;
+  sat_nclause = j;
+  level = 0;
+  for (i = 1; i < sat_nclause; i++) {
+    idx = abs (sat_clause[i]);
+    if (sat_levels[idx] <= level) continue;
+    level = sat_levels[idx];
+    lit = sat_clause[i];
+    sat_clause[i] = sat_clause[1];
+    sat_clause[1] = lit;
+  }
+  glue = 0;
+  for (i = 0; i < sat_nclause; i++) {
+    idx = sat_levels[abs (sat_clause[i])];
+    if (sat_stamps[idx] == sat_conflicts) continue;
+    sat_stamps[idx] = sat_conflicts;
+    glue++;
+  }
+  sat_score_inc *= 1.0 / 0.95;
+  sat_trace_clause ();
+  return (level << 8) | (glue < 255 ? glue : 255);
+}
+
+static int sat_luby (int i) {
+  int k;
+  for (;;) {
+    for (k = 1; (1 << k) - 1 < i; k++)
+      ;
+    if ((1 << k) - 1 == i) return 1 << (k - 1);
+    i -= (1 << (k - 1)) - 1;
+  }
+}
+
+static int sat_decide (void) {
+  int idx;
+  while (sat_nheap) {
+    idx = sat_heap_pop ();
+    if (sat_val (idx)) continue;
+    sat_decisions++;
+    sat_control[sat_level++] = sat_ntrail;
+    sat_assign (sat_phases[idx] > 0 ? idx : -idx, 0);
+    return 1;
+  }
+  return 0;
+}
+
+static int sat_cmp_reduce (const void * p, const void * q) {
+  SatClause * c = *(SatClause **) p, * d = *(SatClause **) q;
+  if (c->glue != d->glue) return d->glue - c->glue;
+  return d->size - c->size;
 }
 
-static void map_vars (void) {
-  Var * v;
-  mapped = 0;
-  assert (trail_flushed ());
-  for (v = vars + 1; v <= vars + num_vars; v++) {
-    if (v->tag != FREE) continue;
-    v->mapped = ++mapped;
-    LOG ("mapped %d to %d", (int)(long)(v - vars), mapped);
+static int sat_reason (SatClause * c) {
+  int lit = c->lits[0];
+  return sat_val (lit) > 0 && sat_reasons[abs (lit)] == c;
+}
+
+static void sat_reduce (void) {
+  SatClause ** candidates, * c;
+  int i, j, n, ncandidates;
+  SatWatches * ws;
+  sat_reductions++;
+  NEWN (candidates, sat_nlearned);
+  ncandidates = 0;
+  for (i = 0; i < sat_nlearned; i++) {
+    c = sat_learned[i];
+    if (c->glue > 2 && !sat_reason (c)) candidates[ncandidates++] = c;
   }
-  if (empty_clause) assert (!mapped), remaining = 0;
-  else assert (mapped == remaining);
+  qsort (candidates, ncandidates, sizeof *candidates, sat_cmp_reduce);
+  for (i = 0; i < ncandidates / 2; i++) candidates[i]->garbage = 1;
+  DELN (candidates, sat_nlearned);
+  n = 2 * (sat_max_var + 1);
+  for (ws = sat_watches; ws < sat_watches + n; ws++) {
+    for (i = j = 0; i < ws->count; i++)
+      if (!ws->watches[i].clause->garbage)
+        ws->watches[j++] = ws->watches[i];
+    ws->count = j;
+  }
+  for (i = j = 0; i < sat_nlearned; i++) {
+    c = sat_learned[i];
+    if (c->garbage) sat_delete_clause (c);
+    else sat_learned[j++] = c;
+  }
+  sat_nlearned = j;
 }
 
-static void print_clause (Clause * c, FILE * file) {
+static int sat_solve (int64_t limit) {
+  int i, res, lit, tmp, luby, nlearned;
+  int64_t conflicts, restart, reduce;
+  double start = seconds ();
+  SatClause * conflict;
+  for (i = 1; i <= sat_max_var; i++) sat_heap_push (i);
+  res = sat_inconsistent ? 20 : 0;
+  for (i = 0; !res && i < sat_nunits; i++) {
+    lit = sat_units[i];
+    if (sat_val (lit) < 0) res = 20;
+    else if (!sat_val (lit)) sat_assign (lit, 0);
+  }
+  conflicts = 0;
+  luby = 1;
+  restart = 100;
+  reduce = 2000;
+  while (!res) {
+    conflict = sat_propagate ();
+    if (conflict) {
+      sat_conflicts++;
+      conflicts++;
+      if (!sat_level) { res = 20; break; }
+      tmp = sat_analyze (conflict);
+      sat_backtrack (tmp >> 8);
+      if (sat_nclause == 1) sat_assign (sat_clause[0], 0);
+      else sat_assign (sat_clause[0], sat_new_clause (1, tmp & 255));
+    } else if (conflicts >= limit) break;
+    else if (conflicts >= restart) {
+      if (sat_deadline && seconds () > sat_deadline) break;
+      if (sat_level) sat_backtrack (0);
+      sat_restarts++;
+      restart = conflicts + 100 * (int64_t) sat_luby (++luby);
+    } else if ((nlearned = sat_nlearned) >= reduce) {
+      sat_reduce ();
+      reduce = nlearned + 300;
+    } else if (!sat_decide ()) res = 10;
+  }
+  if (res == 20) {
+    sat_nclause = 0;
+    sat_trace_clause ();
+  }
+  satTime += seconds () - start;
+  return res;
+}
+
+static int solve_propositional (void) {
+  int res, idx;
+  Clause * c;
   Node * p;
-  for (p = c->nodes; p->lit; p++)
-    fprintf (file, "%d ", map_lit (p->lit));
-  fputs ("0\n", file);
+  Var * v;
+  assert (propositional ());
+  msg ("solving propositional formula with embedded SAT solver");
+  sat_init (num_vars);
+  for (c = first_clause; c; c = c->next) {
+    for (p = c->nodes; p->lit; p++) sat_add (p->lit);
+    sat_add (0);
+  }
+  res = sat_solve (satconflicts);
+  if (res == 10 && partial_assignment) {
+    for (v = vars + 1; v <= vars + num_vars; v++) {
+      if (v->tag != FREE || v->scope->order != assigned_scope) continue;
+      if (v->scope->type < 0) continue;
+      idx = v - vars;
+      v->fixed = (sat_val (idx) > 0) ? idx : -idx;
+      v->tag = SOLVING;
+    }
+  }
+  sat_release ();
+  switch (res) {
+    case 10: msg ("SAT"); break;
+    case 20: msg ("UNSAT"); break;
+    default: msg ("solving aborted after %d conflicts", satconflicts); break;
+  }
+  return res;
 }
 
-static void print_clauses (FILE * file) {
-  Clause * p;
-  for (p = first_clause; p; p = p->next)
-    print_clause (p, file);
+/******** existential relaxation ***********/
+
+/* If the matrix is unsatisfiable with all variables treated as
+ * existential, the formula is false.  This is checked once with the
+ * embedded SAT solver after the first round of unit propagation under
+ * '--relaxconflicts' and '--relaxtime'.  Learned clauses are asymmetric
+ * tautologies and thus valid QRAT additions.  They are traced into a
+ * temporary file, which only becomes part of the trace if the solver
+ * derives the empty clause, so failed checks leave no clauses behind.
+ *
+ * Dually, if the matrix with all universal literals removed is
+ * satisfiable, the model satisfies every clause independent of the
+ * universals, and the formula is true.  The model is then added as
+ * units, which also fixes the outer most block for '-m'.  This direction
+ * is not traced, thus skipped with '--qrat'.
+ */
+
+static void copy_file (FILE * from, FILE * to) {
+  int ch;
+  rewind (from);
+  while ((ch = getc (from)) != EOF) putc (ch, to);
 }
 
-static int print_scope (Scope * s, FILE * file, int pscope) {
-  Var * p;
+static int relax_result;	/* 10 satisfiable, 20 refuted, 0 unknown */
+static int reduce_result;	/* 10 satisfied, 20 unsatisfiable, 0 unknown */
 
-  if (!pscope || (pscope != s->type)) {
-    if (pscope) fputs (" 0\n", file);
-    fputc (s->type < 0 ? 'a' : 'e', file);
-  }
-  for (p = s->first; p; p = p->next) {
-    if (p->tag != FREE) continue;
-    fprintf (file, " %d", map_lit (var2lit (p)));
+static void relax_init (int reduce) {
+  Clause * c;
+  Node * p;
+  sat_init (num_vars);
+  for (c = first_clause; c; c = c->next) {
+    for (p = c->nodes; p->lit; p++)
+      if (!reduce || existential (p->lit)) sat_add (p->lit);
+    sat_add (0);
   }
-  return s->type;
 }
 
-static int empty_scope (Scope * s) {
-  int res = 1;
-  Var * p;
-  for (p = s->first; res && p; p = p->next)
-    if (p->tag == FREE)
-      res = 0;
-  assert (res == !s->free);
+static int relax_solve (void) {
+  int res;
+  sat_deadline = relaxtime ? seconds () + relaxtime : 0;
+  res = sat_solve (relaxconflicts);
+  sat_deadline = 0;
   return res;
 }
 
-static int propositional (void) {
-  Scope * p;
-  for (p = outer_most_scope; p; p = p->inner)
-    if (p->type < 0 && !empty_scope (p)) return 0;
-  return 1;
+static int relax_refute (void) {
+  double start;
+  FILE * proof;
+  if (!relaxsat || empty_clause || !num_clauses) return 0;
+  start = seconds ();
+  proof = 0;
+  if (qrat_file && do_qrat && !(proof = tmpfile ()))
+    die ("can not open temporary QRAT trace");
+  sat_proof = proof;
+  relax_init (0);
+  relax_result = relax_solve ();
+  sat_release ();
+  sat_proof = 0;
+  if (relax_result == 20) {
+    msg ("existential relaxation unsatisfiable");
+    if (proof) copy_file (proof, qrat_file);
+    assert (!num_lits);
+    add_clause ();
+  } else if (relax_result == 10)
+    msg ("existential relaxation satisfiable");
+  else msg ("existential relaxation check aborted");
+  if (proof) fclose (proof);
+  relaxTime += seconds () - start;
+  return relax_result == 20;
 }
 
-static void print_scopes (FILE * file) {
-  int type = 0; 
-  Scope * p, * first = 0;
-  if (propositional () && !quantifyall) return;
-  for (p = outer_most_scope; p; p = p->inner) {
-    if (!quantifyall && !first && p->type > 0) continue;
-    if (empty_scope (p)) { continue; }
-    first = p;
-    type = print_scope (p, file, type);
-  }
-  if (type) fputs (" 0\n", file);
+static int reduce_satisfy (void) {
+  double start;
+  int idx;
+  Var * v;
+  if (!reducesat || qrat_file || empty_clause || !num_clauses) return 0;
+  start = seconds ();
+  relax_init (1);
+  reduce_result = relax_solve ();
+  if (reduce_result == 10) {
+    msg ("universally reduced matrix satisfiable");
+    for (idx = 1; idx <= num_vars; idx++) {
+      v = vars + idx;
+      if (v->tag != FREE || v->scope->type < 0) continue;
+      push_literal (sat_val (idx) < 0 ? -idx : idx);
+      add_clause ();
+    }
+  } else if (reduce_result == 20)
+    msg ("universally reduced matrix unsatisfiable");
+  else msg ("universally reduced matrix check aborted");
+  sat_release ();
+  if (reduce_result == 10) flush (1);
+  relaxTime += seconds () - start;
+  return reduce_result == 10;
 }
 
-static void print (FILE * file) {
-  fprintf (file, "p cnf %d %d\n", mapped, num_clauses);
-  print_scopes (file);
-  print_clauses (file);
+static int preprocess (void) {
+  int res, first;
+  flush_vars ();
+  for (first = 1;; first = 0) {
+    subsume_round ();
+    flush (1);
+    if (first && (relax_refute () || reduce_satisfy ())) break;
+    split ();
+    if (empty_clause || !num_clauses) break;
+    if (eqres (1)) flush (0);
+    if (empty_clause || !num_clauses) break;
+    unhiding ();
+    probing ();
+    flush (0);
+    if (empty_clause || !num_clauses) break;
+    elim ();
+    if (verbose) log_pruned_scopes ();
+    if (empty_clause || !num_clauses) break;
+    vivify ();
+    ate ();
+    if (empty_clause || !num_clauses) break;
+    if (propositional ()) break;
+    reorder_prefix ();
+    flush (1);
+    if (empty_clause || !num_clauses) break;
+    if (!try_expand ()) break;
+  }
+  flush_trail ();
+  if (!empty_clause && num_clauses) variable_addition ();
+  if (empty_clause) { res = 20; msg ("definitely UNSATISFIABLE"); }
+  else if (!num_clauses) { res = 10; msg ("definitely SATISFIABLE"); }
+  else { res = 0; msg ("unknown status"); }
+  split ();
+  if (keep) remaining = num_vars; else map_vars ();
+  return res;
 }
 
 static void release_clauses (void) {
@@ -5201,9 +8448,36 @@ static void release_scopes (void) {
   }
 }
 
+static void release_workers (void) {
+  Worker * w;
+  for (w = workers; w < workers + nworkers; w++) {
+    DELN (w->marks, szmarks);
+    DELN (w->pos, szmarks);
+    DELN (w->stack, szmarks);
+    free (w->buf);
+  }
+  DELN (workers, nworkers);
+  nworkers = szmarks = 0;
+  workers = 0;
+  DELN (candidates, szcandidates);
+  szcandidates = ncandidates = 0;
+  candidates = 0;
+  DELN (exp_candidates, szexp_candidates);
+  szexp_candidates = nexp_candidates = 0;
+  exp_candidates = 0;
+  DELN (exp_copies, szexp_copies);
+  szexp_copies = nexp_copies = 0;
+  exp_copies = 0;
+  DELN (exp_looks, szexp_looks);
+  szexp_looks = nexp_looks = 0;
+  exp_looks = 0;
+}
+
 static void release (void) {
+  int i;
   release_clauses ();
   release_scopes ();
+  release_workers ();
   DELN (line, szline);
   szline = 0;
   line = NULL;
@@ -5218,6 +8492,17 @@ static void release (void) {
   DELN (aux, szaux);
   szaux = 0;
   aux = NULL;
+  DELN (bulk, szbulk);
+  szbulk = nbulk = 0;
+  bulk = NULL;
+  DELN (dirty, szdirty);
+  szdirty = ndirty = 0;
+  dirty = NULL;
+  DELN (maxdep, szmaxdep);
+  szmaxdep = depvalid = 0;
+  maxdep = NULL;
+  for (i = 1; i <= num_vars; i++)
+    DELN (vars[i].cone, vars[i].ncone);
   DELN (vars, num_vars + 1);
   vars = NULL;
   dfsi -= num_vars;
@@ -5355,8 +8640,8 @@ static void stats (void) {
   msg ("%d zombie variables %.0f%%", zombies, percent (zombies, num_vars));
   msg ("%d eliminated variables %.0f%%", 
        eliminated, percent (eliminated, num_vars));
-  msg ("%d expanded variables %.0f%%", 
-       expanded, percent (expanded, num_vars));
+  msg ("%d expanded variables %.0f%% (%d jointly)", 
+       expanded, percent (expanded, num_vars), block_expanded);
   msg ("%d substituted variables %.0f%%", 
        substituted, percent (substituted, num_vars));
   msg ("%d existential pure literals %.0f%%", 
@@ -5388,6 +8673,10 @@ static void stats (void) {
   msg ("%d forward strengthened (%.0f%% of all strengthened clauses)",
        forward_strengthened_clauses,
        percent (forward_strengthened_clauses, strengthened_clauses));
+  msg ("%d bulk insertions with %d subsumed and %d strengthened clauses",
+       bulk_batches, bulk_subsumed_clauses, bulk_strengthened_clauses);
+  msg ("%d subsumption rounds with %d subsumed and %d strengthened clauses",
+       subsume_rounds, round_subsumed_clauses, round_strengthened_clauses);
   msg ("");
   msg ("%lld fwsig1 lookups with %lld hits (%.0f%% hit rate)",
        fw.sig1.lookups, fw.sig1.hits, percent (fw.sig1.hits, fw.sig1.lookups));
@@ -5408,6 +8697,18 @@ static void stats (void) {
   msg ("%d not blocked clauses because pivot in outermost scope",outermost_blocked);
   msg ("%d hidden tautologies %.0f%% of all added clauses", 
        hidden_tautologies, percent (hidden_tautologies, added_clauses));
+  msg ("%d unhiding rounds with %d tautologies and %d transitive clauses",
+       unhide_rounds, unhidden_tautologies, unhidden_transitive);
+  msg ("%d unhidden literals and %d failed literals",
+       unhidden_literals, unhidden_units);
+  msg ("%d probing rounds with %d probed, %d failed and %d lifted literals",
+       probe_rounds, probed_lits, failed_lits, lifted_lits);
+  msg ("%d vivification rounds with %d clauses, %d literals and %d redundant",
+       vivify_rounds, vivified_clauses, vivified_lits, vivified_redundant);
+  msg ("%d ate rounds with %d asymmetric tautologies and %d qrat clauses",
+       ate_rounds, ate_clauses, qrate_clauses);
+  msg ("%d variables added replacing %d by %d clauses",
+       bva_vars, bva_removed, bva_added);
   msg ("%d asymmetric blocked literals", 
        hidden_blocked_literals);
   msg ("%d hidden blocked clauses %.0f%% of all added clauses", 
@@ -5415,6 +8716,41 @@ static void stats (void) {
        percent (hidden_blocked_clauses, added_clauses));
   msg ("%d non-strict variable eliminations %.0f%%",
        nonstrictves, percent (nonstrictves, eliminated));
+  msg ("%d gate eliminations %.0f%% (%d equivalence, %d and, %d xor, %d ite)",
+       gate_eliminations, percent (gate_eliminations, eliminated),
+       gate_types[1], gate_types[2], gate_types[3], gate_types[4]);
+  msg ("%d dependency computations, %d blocked, %d eliminated, %d not copied",
+       dep_computations, dep_blocked, dep_eliminated, dep_uncopied);
+  msg ("%d prefix reorderings shifted %d existentials out, %d clauses re-added",
+       reorders, reordered_vars, reordered_clauses);
+  if (exp_cache_lookups)
+    msg ("%lld expansion cost cache hits %.0f%% of %lld lookups",
+         (long long) exp_cache_hits,
+         percent (exp_cache_hits, exp_cache_lookups),
+         (long long) exp_cache_lookups);
+  if (exp_parallel_copies)
+    msg ("%lld expansion copies built in parallel",
+         (long long) exp_parallel_copies);
+  if (ve_batches)
+    msg ("%lld elimination batches, %lld parallel candidates %lld pruned, "
+         "%lld overlapping",
+         (long long) ve_batches, (long long) ve_parallel,
+         (long long) ve_pruned, (long long) ve_overlapping);
+  if (sat_conflicts || sat_decisions) {
+    msg ("");
+    msg ("%lld SAT conflicts, %lld decisions, %lld propagations",
+         (long long) sat_conflicts, (long long) sat_decisions,
+         (long long) sat_propagations);
+    msg ("%lld SAT restarts, %lld learned clause reductions",
+         (long long) sat_restarts, (long long) sat_reductions);
+  }
+  if (relaxsat)
+    msg ("existential relaxation %s", relax_result == 20 ? "unsatisfiable" :
+         (relax_result == 10 ? "satisfiable" : "unknown"));
+  if (reducesat)
+    msg ("universally reduced matrix %s",
+         reduce_result == 10 ? "satisfiable" :
+         (reduce_result == 20 ? "unsatisfiable" : "unknown"));
   msg ("");
   msg ("%d remaining variables %.0f%% out of %d", 
        remaining, percent (remaining, num_vars), num_vars);
@@ -5424,6 +8760,12 @@ static void stats (void) {
   msg ("%.3f seconds, %.1f MB", seconds (), max_bytes /(double)(1<<20));
   msg ("parse time: %.3f", parseTime);
   msg ("hte time: %.3f", hteTime);  
+  msg ("unhide time: %.3f", unhideTime);  
+  msg ("deps time: %.3f", depTime);  
+  msg ("probe time: %.3f", probeTime);  
+  msg ("vivify time: %.3f", vivifyTime);  
+  msg ("ate time: %.3f", ateTime);  
+  msg ("bva time: %.3f", bvaTime);  
   msg ("bce time: %.3f", bceTime);  
   msg ("eq time: %.3f", eqTime);  
   msg ("ve time: %.3f", veTime);  
@@ -5438,7 +8780,9 @@ static void stats (void) {
   msg ("pure time: %.3f", pureTime);  
   msg ("elim time: %.3f", elimTime);  
   msg ("flush time: %.3f", flushTime);  
-  double sum = hteTime+bceTime+eqTime+veTime+hbceTime+splitTime+expTime+strengthTime+subsTime+univredTime+trivclauseTime;
+  msg ("sat time: %.3f", satTime);  
+  msg ("relax time: %.3f", relaxTime);  
+  double sum = hteTime+bceTime+eqTime+veTime+hbceTime+splitTime+expTime+strengthTime+subsTime+univredTime+trivclauseTime+unhideTime+depTime+probeTime+vivifyTime+ateTime+bvaTime;
   msg ("total time: %.3f", sum);
 }
 
@@ -5552,21 +8896,6 @@ static int solve () {
 
 }
 
-static void print_part_assignment (int scope) {
-  int i; 
-  Var v;
-  if (!partial_assignment) return;
-
-
-  for (i = 1; i <= num_vars; i++) {
-    v = vars[i];
-    if (v.scope->order == scope)  {
-	fprintf(stderr,"%d %d\n",v.fixed,bloqqer_getvalue(i));
-    }
-  }
-
-}
-
 #endif
 
 
@@ -5659,6 +8988,18 @@ void bloqqer_decl_var ( int var ) {
 }
 
 
+void bloqqer_add_clauses (const int * clauses, size_t n) {
+  size_t i;
+  if (!implicit_scopes_inited) {
+    implicit_scopes_inited = 1;
+    init_implicit_scope ();
+  }
+  for (i = 0; i < n; i++)
+    if (!clauses[i]) remaining_clauses_to_parse--;
+  add_clauses (clauses, n, 0);
+}
+
+
 void bloqqer_add ( int lit ) {
   if (!implicit_scopes_inited) {
     implicit_scopes_inited = 1;
@@ -5688,25 +9029,8 @@ int bloqqer_preprocess () {
   }
 
 
-  flush_vars ();
-  for (;;) {
-    flush (1);
-    split ();
-    if (empty_clause || !num_clauses) break;
-    if (eqres (1)) flush (0);
-    if (empty_clause || !num_clauses) break;
-    elim ();
-    if (verbose) log_pruned_scopes ();
-    if (empty_clause || !num_clauses) break;
-    if (propositional ()) break;
-    if (!try_expand ()) break;
-  }
-  if (empty_clause) { res = 20; msg ("definitely UNSATISFIABLE"); }
-  else if (!num_clauses) { res = 10; msg ("definitely SATISFIABLE"); }
-  else { res = 0; msg ("unknown status"); }
-  split ();
-  if (keep) remaining = num_vars; else map_vars ();
- 
+  res = preprocess ();
+  if (sat && !res && propositional ()) res = solve_propositional ();
   return res;
 }
 
@@ -5913,8 +9237,401 @@ void bloqqer_reset_option_iterator () {
 
 
 #ifndef LIBBLOQQER
+
+/* Option vectors tried in portfolio mode.  They are applied on top of
+ * the command line and embedded options after parsing the input, which
+ * is shared copy-on-write by all forked children.
+ */
+static const char * portfolio_configs[] = {
+  "",
+  "--axcess=20000 --excess=100",
+  "--no-exp",
+  "--no-hte --no-cce --no-hbce",
+  "--axcess=200 --excess=5",
+  "--bound=8192 --htesteps=1024",
+  "--no-exp-mini --axcess=5000",
+  "--hble --strict",
+  0
+};
+
+typedef struct Result {
+  int res, clauses;
+  int64_t literals;
+  double time;
+} Result;
+
+typedef struct Portfolio {
+  int pid, fd, reaped, done;
+  Result result;
+  FILE * output, * trace;
+} Portfolio;
+
+static const char * objectives[] = { "clauses", "literals", "result", "time" };
+static FILE * portfolio_output;
+
+static void configure_portfolio (const char * config) {
+  char buffer[128], * p, * q;
+  assert (strlen (config) < sizeof buffer);
+  strcpy (buffer, config);
+  for (p = buffer; *p; p = q) {
+    while (*p == ' ') p++;
+    for (q = p; *q && *q != ' '; q++)
+      ;
+    if (*q) *q++ = 0;
+    if (*p && !parse_opt (p)) die ("invalid portfolio option '%s'", p);
+  }
+}
+
+static void portfolio_child (Portfolio * w, const char * config) {
+  Result r;
+  Clause * c;
+  configure_portfolio (config);
+  verbose = 0;
+  if (timelimit) alarm (timelimit);
+  if (w->trace) qrat_file = w->trace;
+  r.res = preprocess ();
+  print (w->output);
+  fflush (w->output);
+  if (qrat_file) fflush (qrat_file);
+  r.clauses = num_clauses;
+  r.literals = 0;
+  for (c = first_clause; c; c = c->next) r.literals += c->size;
+  r.time = seconds ();
+  if (write (w->fd, &r, sizeof r) != sizeof r) _exit (1);
+  _exit (0);
+}
+
+static int portfolio_better (Result * a, Result * b) {
+  if (objective == 1 && a->literals != b->literals)
+    return a->literals < b->literals;
+  return a->clauses < b->clauses;
+}
+
+static int portfolio_preprocess (void) {
+  Portfolio workers[sizeof portfolio_configs / sizeof *portfolio_configs];
+  int i, n, fds[2], status, pid, running;
+  Portfolio * w, * winner;
+  assert (portfolio < sizeof workers / sizeof *workers);
+  n = portfolio;
+  msg ("portfolio of %d configurations with objective '%s'",
+       n, objectives[objective]);
+  fflush (stdout);
+  if (qrat_file) fflush (qrat_file);
+  for (i = 0; i < n; i++) {
+    w = workers + i;
+    memset (w, 0, sizeof *w);
+    if (!(w->output = tmpfile ())) die ("can not create temporary file");
+    if (qrat_file && !(w->trace = tmpfile ()))
+      die ("can not create temporary file");
+    if (pipe (fds)) die ("can not create pipe");
+    w->fd = fds[1];
+    pid = fork ();
+    if (pid < 0) die ("can not fork portfolio configuration %d", i);
+    if (!pid) { close (fds[0]); portfolio_child (w, portfolio_configs[i]); }
+    close (fds[1]);
+    w->fd = fds[0];
+    w->pid = pid;
+    msg ("portfolio configuration %d '%s' started as process %d",
+         i, portfolio_configs[i], pid);
+  }
+  winner = 0;
+  for (running = n; running; running--) {
+    pid = wait (&status);
+    if (pid < 0) die ("waiting for portfolio processes failed");
+    for (w = workers; w->pid != pid; w++)
+      assert (w < workers + n - 1);
+    w->reaped = 1;
+    w->done = WIFEXITED (status) && !WEXITSTATUS (status) &&
+              read (w->fd, &w->result, sizeof w->result) == sizeof w->result;
+    close (w->fd);
+    i = w - workers;
+    if (!w->done) { msg ("portfolio configuration %d failed", i); continue; }
+    msg ("portfolio configuration %d finished with result %d, "
+         "%d clauses, %lld literals in %.2f seconds",
+         i, w->result.res, w->result.clauses,
+         (long long) w->result.literals, w->result.time);
+    if (objective == 3 || (objective == 2 && w->result.res)) {
+      winner = w;
+      break;
+    }
+    if (!winner || portfolio_better (&w->result, &winner->result))
+      winner = w;
+  }
+  for (w = workers; w < workers + n; w++) {
+    if (!w->reaped) {
+      kill (w->pid, SIGKILL);
+      waitpid (w->pid, 0, 0);
+      close (w->fd);
+    }
+    if (w == winner) continue;
+    fclose (w->output);
+    if (w->trace) fclose (w->trace);
+  }
+  if (!winner) die ("all portfolio configurations failed");
+  i = winner - workers;
+  msg ("portfolio configuration %d '%s' won with %d clauses",
+       i, portfolio_configs[i], winner->result.clauses);
+  if (winner->trace) {
+    copy_file (winner->trace, qrat_file);
+    fclose (winner->trace);
+  }
+  portfolio_output = winner->output;
+  return winner->result.res;
+}
+
+/* The matrix often is a conjunction of sub-formulas over disjoint sets of
+ * variables.  These connected components are distributed over at most
+ * 'components' many forked children, which preprocess their share of the
+ * clauses independently.  The results are merged back into the parent,
+ * such that 'map_vars' renumbers all of them consistently.  The formula is
+ * unsatisfiable as soon as one of the components is.
+ */
+
+typedef struct Component {
+  int pid, reaped, clauses;
+  FILE * file;
+} Component;
+
+static int * component_clauses;
+
+static int find_component (int * roots, int idx) {
+  int res, tmp;
+  for (res = idx; roots[res] != res; res = roots[res])
+    ;
+  while (idx != res) tmp = roots[idx], roots[idx] = res, idx = tmp;
+  return res;
+}
+
+static int cmp_components (const void * p, const void * q) {
+  int a = *(int *) p, b = *(int *) q;
+  if (component_clauses[a] != component_clauses[b])
+    return component_clauses[b] - component_clauses[a];
+  return a - b;
+}
+
+static void component_child (Component * w, int * buckets, int bucket) {
+  int idx, orig, free_vars, res;
+  Clause * c, * next;
+  Node * p;
+  Var * v;
+  verbose = 0;
+  if (timelimit) alarm (timelimit);
+  for (c = first_clause; c; c = next) {
+    next = c->next;
+    if (buckets[abs (c->nodes[0].lit)] != bucket) delete_clause (c);
+  }
+  orig = num_vars;
+  res = preprocess ();
+  free_vars = 0;
+  for (idx = orig + 1; idx <= num_vars; idx++)
+    if (vars[idx].tag == FREE) free_vars++;
+  fprintf (w->file, "%d %d %d\n", res, num_vars, free_vars);
+  for (idx = 1; idx <= num_vars; idx++) {
+    v = vars + idx;
+    if (idx <= orig) {
+      if (buckets[idx] != bucket || v->tag == FREE) continue;
+    } else if (v->tag != FREE) continue;
+    fprintf (w->file, "v %d %d %d %d\n", idx, v->tag, v->fixed, v->scope->order);
+  }
+  for (c = first_clause; c; c = c->next) {
+    fputc ('c', w->file);
+    for (p = c->nodes; p->lit; p++) fprintf (w->file, " %d", p->lit);
+    fputs (" 0\n", w->file);
+  }
+  if (fflush (w->file) || ferror (w->file)) _exit (1);
+  _exit (0);
+}
+
+static void merge_var (int idx, int tag, int fixed) {
+  Var * v = vars + idx;
+  if (tag == FREE || v->tag != FREE) return;
+  switch (tag) {
+    case UNET: unets++; break;
+    case UNATE: unates++; break;
+    case ZOMBIE: zombies++; break;
+    case ELIMINATED: eliminated++; break;
+    case SUBSTITUTED: substituted++; break;
+    case EXPANDED: expanded++; break;
+    default: assert (tag == FIXED || tag == UNIT); fixed++; break;
+  }
+  tag_var (v, tag);
+  v->fixed = fixed;
+  assert (remaining > 0);
+  remaining--;
+}
+
+static void merge_component (Component * w, int orig) {
+  int res, child_vars, free_vars, idx, tag, val, order, lit, first, ch;
+  int * map;
+  Scope * s;
+  rewind (w->file);
+  if (fscanf (w->file, "%d %d %d", &res, &child_vars, &free_vars) != 3)
+    die ("invalid component result");
+  first = num_vars;
+  if (free_vars) enlarge_vars (num_vars + free_vars);
+  NEWN (map, child_vars - orig + 1);
+  while ((ch = getc (w->file)) != EOF) {
+    if (ch == 'v') {
+      if (fscanf (w->file, "%d %d %d %d", &idx, &tag, &val, &order) != 4)
+        die ("invalid component variable");
+      if (idx <= orig) { merge_var (idx, tag, val); continue; }
+      assert (tag == FREE);
+      map[idx - orig] = ++first;
+      if (order > inner_most_scope->order) {
+        add_quantifier (first);
+        assert (inner_most_scope->order == order);
+        continue;
+      }
+      for (s = inner_most_scope; s->order != order; s = s->outer)
+        assert (s->outer);
+      add_var (first, s);
+    } else if (ch == 'c') {
+      assert (!num_lits);
+      while (fscanf (w->file, "%d", &lit) == 1 && lit) {
+        idx = abs (lit);
+        if (idx > orig) {
+          assert (idx <= child_vars && map[idx - orig]);
+          idx = map[idx - orig];
+        }
+        push_literal (lit < 0 ? -idx : idx);
+      }
+      add_clause ();
+    }
+  }
+  assert (first == num_vars);
+  DELN (map, child_vars - orig + 1);
+}
+
+static int components_preprocess (void) {
+  int i, j, n, idx, root, best, ncomps, status, pid, running, res, orig;
+  int * roots, * buckets, * comps, * load;
+  Component * workers, * w;
+  Clause * c, * last, * next;
+  Node * p;
+  if (qrat_file || partial_assignment) {
+    msg ("component decomposition disabled by tracing or assignments");
+    return -1;
+  }
+  flush_vars ();
+  flush_trail ();
+  if (empty_clause || !num_clauses) return -1;
+  orig = num_vars;
+  NEWN (roots, num_vars + 1);
+  NEWN (component_clauses, num_vars + 1);
+  for (idx = 1; idx <= num_vars; idx++) roots[idx] = idx;
+  for (c = first_clause; c; c = c->next) {
+    root = find_component (roots, abs (c->nodes[0].lit));
+    for (p = c->nodes + 1; p->lit; p++) {
+      idx = find_component (roots, abs (p->lit));
+      if (idx != root) roots[idx] = root;
+    }
+  }
+  ncomps = 0;
+  NEWN (comps, num_vars + 1);
+  for (c = first_clause; c; c = c->next) {
+    root = find_component (roots, abs (c->nodes[0].lit));
+    if (!component_clauses[root]++) comps[ncomps++] = root;
+  }
+  msg ("found %d connected components", ncomps);
+  res = -1;
+  if (ncomps > 1) {
+    n = components < ncomps ? components : ncomps;
+    qsort (comps, ncomps, sizeof *comps, cmp_components);
+    NEWN (buckets, num_vars + 1);
+    NEWN (load, n);
+    for (idx = 1; idx <= num_vars; idx++) buckets[idx] = -1;
+    for (i = 0; i < ncomps; i++) {
+      root = comps[i];
+      best = 0;
+      for (j = 1; j < n; j++)
+        if (load[j] < load[best]) best = j;
+      load[best] += component_clauses[root];
+      buckets[root] = best;
+    }
+    for (idx = 1; idx <= num_vars; idx++)
+      if (component_clauses[find_component (roots, idx)])
+        buckets[idx] = buckets[find_component (roots, idx)];
+    NEWN (workers, n);
+    fflush (stdout);
+    for (i = 0; i < n; i++) {
+      w = workers + i;
+      w->clauses = load[i];
+      if (!(w->file = tmpfile ())) die ("can not create temporary file");
+      pid = fork ();
+      if (pid < 0) die ("can not fork component process %d", i);
+      if (!pid) component_child (w, buckets, i);
+      w->pid = pid;
+      msg ("component process %d with %d clauses started as process %d",
+           i, w->clauses, pid);
+    }
+    for (running = n; running; running--) {
+      pid = wait (&status);
+      if (pid < 0) die ("waiting for component processes failed");
+      for (w = workers; w->pid != pid; w++)
+        assert (w < workers + n - 1);
+      w->reaped = 1;
+      if (!WIFEXITED (status) || WEXITSTATUS (status))
+        die ("component process %d failed", (int)(w - workers));
+      rewind (w->file);
+      if (fscanf (w->file, "%d", &res) != 1)
+        die ("invalid component result");
+      msg ("component process %d finished with result %d",
+           (int)(w - workers), res);
+      if (res == 20) break;
+    }
+    /* The residuals are added before the original clauses are deleted.
+     * Otherwise deleting the originals would assign variables as pure,
+     * which still occur in the residuals.  Forward subsumption is
+     * disabled, since the originals would subsume identical residuals.
+     */
+    last = last_clause;
+    if (res == 20) assert (!num_lits), add_clause ();
+    bulk_adding = 1;
+    for (w = workers; w < workers + n; w++) {
+      if (!w->reaped) {
+        kill (w->pid, SIGKILL);
+        waitpid (w->pid, 0, 0);
+      } else if (res != 20) merge_component (w, orig);
+      fclose (w->file);
+    }
+    bulk_adding = 0;
+    for (c = first_clause; c; c = next) {
+      next = (c == last) ? 0 : c->next;
+      delete_clause (c);
+    }
+    DELN (workers, n);
+    DELN (load, n);
+    DELN (buckets, orig + 1);
+    flush_vars ();
+    flush_trail ();
+    if (empty_clause) { res = 20; msg ("definitely UNSATISFIABLE"); }
+    else if (!num_clauses) { res = 10; msg ("definitely SATISFIABLE"); }
+    else { res = 0; msg ("unknown status"); }
+    if (keep) remaining = num_vars; else map_vars ();
+  }
+  DELN (comps, orig + 1);
+  DELN (component_clauses, orig + 1);
+  DELN (roots, orig + 1);
+  return res;
+}
+
+static void print_part_assignment (int scope) {
+  int i; 
+  Var v;
+  if (!partial_assignment) return;
+
+
+  for (i = 1; i <= num_vars; i++) {
+    v = vars[i];
+    if (v.scope->order == scope)  {
+	fprintf(stderr,"%d %d\n",v.fixed,bloqqer_getvalue(i));
+    }
+  }
+
+}
+
 int main (int argc, char ** argv) {
-  int ifclose, ipclose, oclose;
+  int ifclose, ipclose, oclose, solved;
   FILE * ifile, * ofile;
   char * iname, * oname;
   const char * perr;
@@ -6008,27 +9725,10 @@ int main (int argc, char ** argv) {
     
   } 
 
-  flush_vars ();
-  for (;;) {
-    flush (1);
-    split ();
-    if (empty_clause || !num_clauses) break;
-    if (eqres (1)) flush (0);
-    if (empty_clause || !num_clauses) break;
-    elim ();
-    if (verbose) log_pruned_scopes ();
-    if (empty_clause || !num_clauses) break;
-    if (propositional ()) break;
-    flush (1);
-    if (!try_expand ()) break;
-  }
-  flush_trail ();
-  if (empty_clause) { res = 20; msg ("definitely UNSATISFIABLE"); }
-  else if (!num_clauses) { res = 10; msg ("definitely SATISFIABLE"); }
-  else { res = 0; msg ("unknown status"); }
-  split ();
-  if (keep) remaining = num_vars; else map_vars ();
-
+  res = -1;
+  if (portfolio) res = portfolio_preprocess ();
+  else if (components) res = components_preprocess ();
+  if (res < 0) res = preprocess ();
 
   if (oname && strcmp (oname, "-")) {
     assert (output);
@@ -6039,18 +9739,27 @@ int main (int argc, char ** argv) {
     ofile = stdout;
     oname = "<stdout>";
   }
-  if (propositional ()) msg ("result is propositional");
-  else msg ("result still contains universal quantifiers");
-  if (output) print (ofile);
+  if (portfolio_output) {
+    if (output) copy_file (portfolio_output, ofile);
+    fclose (portfolio_output);
+  } else {
+    if (propositional ()) msg ("result is propositional");
+    else msg ("result still contains universal quantifiers");
+    if (output) print (ofile);
+  }
 
+  solved = 0;
+  if (sat && !res && !portfolio_output && propositional ()) {
+    res = solve_propositional ();
+    solved = (res != 0);		/* zero if '--satconflicts' was hit */
+  }
 #ifdef SOLVER 
-  if (depqbf_on) {
+  if (depqbf_on && !solved) {
     res = solve();
-    if (partial_assignment) {
-      print_part_assignment(assigned_scope);
-    }  
+    solved = 1;
   } 
 #endif
+  if (solved && partial_assignment) print_part_assignment (assigned_scope);
   if (oclose) fclose (ofile);
   if (qrat_trace) fclose (qrat_file);
   release ();
@@ -1,6 +1,8 @@
 #ifndef BLOQQER_H_INCLUDED
 #define BLOQQER_H_INCLUDED
 
+#include <stddef.h>
+
 
 
 typedef enum VarValue {
@@ -25,6 +27,12 @@ void bloqqer_decl_var ( int );
 void bloqqer_add ( int );
 
 
+/** add n literals forming clauses, each terminated by 0, 
+  * with subsumption checks done once for all of them
+  */
+void bloqqer_add_clauses ( const int *, size_t );
+
+
 /** do preprocessing 
   */
 int bloqqer_preprocess ();
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Runs 'bloqqer' on every 'test/*.q' file.  The first line of each file
+# has the form 'c expect <exit code> <options>'.
+dir=`dirname $0`
+bin=$dir/../bloqqer
+failed=0
+for file in $dir/*.q
+do
+  set -- `head -1 $file`
+  expected=$3
+  shift 3
+  $bin -q "$@" $file > /dev/null 2>&1
+  res=$?
+  if [ $res = $expected ]
+  then
+    echo "ok $file"
+  else
+    echo "FAILED $file: exit code $res, expected $expected"
+    failed=1
+  fi
+done
+exit $failed